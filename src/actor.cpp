@@ -452,7 +452,7 @@ bool ActionData::apply(Ship* ship, pcg32& rng)
     case Action::Zap:
     {
         auto path = map.findRay(actor->pos, move);
-        g_game.animations.push_back(new ProjectileAnimation(actor->pos, move, 0xFFFFFFFF));
+        g_game.animations.projectile(actor->pos, move, 0xFFFFFFFF);
         for (vec2i p : path)
         {
             if (actor->pos == p) continue;
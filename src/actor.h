@@ -16,19 +16,20 @@ struct Item
     int character;
     u32 color;
     ItemType type;
-    sstring name;
+    istring name;
 
     int count = 1;
 
-    Item(int id, u32 color, ItemType type, const sstring& name) : character(id), color(color), type(type), name(name) {}
-    Item(int id, u32 color, ItemType type, const sstring& name, int count) : character(id), color(color), type(type), name(name), count(count) {}
+    Item(int id, u32 color, ItemType type, istring name) : character(id), color(color), type(type), name(name) {}
+    Item(int id, u32 color, ItemType type, istring name, int count) : character(id), color(color), type(type), name(name), count(count) {}
 
-    sstring getName() const
+    // Appends the name with the stack size, e.g. "Torpedoes (x5)".
+    template<typename String>
+    void appendName(String& s) const
     {
-        sstring s = name;
+        s.append(name.c_str());
         if (count > 1)
             s.appendf(" (x%d)", count);
-        return s;
     }
 };
 
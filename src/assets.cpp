@@ -0,0 +1,218 @@
+#include "assets.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "util/string.h"
+
+#include "profiler.h"
+
+// Everything the game loads, packed by --pack-assets.
+const char* asset_names[] = {
+    "asteroid_impact.wav",
+    "levelloopmaybe.wav",
+    "levelloopmaybedrumver.wav",
+    "pdc_fire.wav",
+    "railgun_fire.wav",
+    "railgun_impact.wav",
+    "reactor_shutdown.wav",
+    "reactor_start.wav",
+    "rl_text16.png",
+    "ship_0.png",
+    "ship_1.png",
+    "ship_2.png",
+    "ship_3.png",
+    "ship_4.png",
+    "ship_5.png",
+    "ship_6.png",
+    "ship_cover.png",
+    "torpedo_impact.wav",
+    "torpedo_launch.wav",
+};
+
+struct AssetArchiveHeader
+{
+    u32 magic;
+    u32 version;
+    u32 count;
+    u32 unused;
+};
+
+struct AssetEntry
+{
+    char name[48];
+    u64 offset;
+    u64 size;
+};
+
+// Only written by openAssetArchive before any loads start, so the loader threads can read it freely.
+struct AssetArchive
+{
+    std::vector<u8> data;
+    const AssetEntry* entries = nullptr;
+    u32 count = 0;
+};
+AssetArchive g_assets;
+
+bool openAssetArchive(const char* path)
+{
+    PROFILE_ZONE("openAssetArchive");
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    std::vector<u8> data(size > 0 ? (size_t)size : 0);
+    bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+    fclose(f);
+    if (!ok || data.size() < sizeof(AssetArchiveHeader)) return false;
+
+    AssetArchiveHeader header;
+    memcpy(&header, data.data(), sizeof(header));
+    if (header.magic != AssetArchiveMagic || header.version != AssetArchiveVersion) return false;
+    size_t index_end = sizeof(header) + (size_t)header.count * sizeof(AssetEntry);
+    if (index_end > data.size()) return false;
+    const AssetEntry* entries = (const AssetEntry*)(data.data() + sizeof(header));
+    for (u32 i = 0; i < header.count; ++i)
+    {
+        const AssetEntry& e = entries[i];
+        if (e.name[sizeof(e.name) - 1] != 0 || e.offset > data.size() || e.size > data.size() - e.offset) return false;
+    }
+
+    g_assets.data = std::move(data);
+    g_assets.entries = (const AssetEntry*)(g_assets.data.data() + sizeof(header));
+    g_assets.count = header.count;
+    return true;
+}
+
+bool writeAssetArchive(const char* path)
+{
+    std::vector<AssetEntry> entries;
+    std::vector<u8*> files;
+    for (const char* name : asset_names)
+    {
+        sstring file;
+        file.appendf("assets/%s", name);
+        int size = 0;
+        u8* data = FileExists(file.c_str()) ? LoadFileData(file.c_str(), &size) : nullptr;
+        if (!data)
+        {
+            printf("Skipping missing %s\n", file.c_str());
+            continue;
+        }
+        AssetEntry& e = entries.emplace_back();
+        memset(&e, 0, sizeof(e));
+        strncpy(e.name, name, sizeof(e.name) - 1);
+        e.size = size;
+        files.push_back(data);
+    }
+
+    // Blobs start 16 byte aligned so decoders can read them in place.
+    u64 offset = sizeof(AssetArchiveHeader) + entries.size() * sizeof(AssetEntry);
+    for (AssetEntry& e : entries)
+    {
+        offset = (offset + 15) & ~15ull;
+        e.offset = offset;
+        offset += e.size;
+    }
+
+    std::vector<u8> out(offset, 0);
+    AssetArchiveHeader header{ AssetArchiveMagic, AssetArchiveVersion, (u32)entries.size(), 0 };
+    memcpy(out.data(), &header, sizeof(header));
+    if (!entries.empty())
+        memcpy(out.data() + sizeof(header), entries.data(), entries.size() * sizeof(AssetEntry));
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        memcpy(out.data() + entries[i].offset, files[i], entries[i].size);
+        UnloadFileData(files[i]);
+    }
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    printf("Packed %d assets into %s (%llu bytes)\n", (int)entries.size(), path, (unsigned long long)out.size());
+    return ok;
+}
+
+const AssetEntry* findAsset(const char* name)
+{
+    for (u32 i = 0; i < g_assets.count; ++i)
+    {
+        if (strings::equals(g_assets.entries[i].name, name)) return &g_assets.entries[i];
+    }
+    return nullptr;
+}
+
+sstring looseAssetPath(const char* name)
+{
+    sstring path;
+    path.appendf("assets/%s", name);
+    return path;
+}
+
+bool assetExists(const char* name)
+{
+    return findAsset(name) || FileExists(looseAssetPath(name).c_str());
+}
+
+AssetBlob readAsset(const char* name)
+{
+    AssetBlob blob;
+    if (const AssetEntry* e = findAsset(name))
+    {
+        blob.data = g_assets.data.data() + e->offset;
+        blob.size = (int)e->size;
+        return blob;
+    }
+    sstring path = looseAssetPath(name);
+    if (!FileExists(path.c_str())) return blob;
+    blob.owned = LoadFileData(path.c_str(), &blob.size);
+    blob.data = blob.owned;
+    return blob;
+}
+
+void releaseAsset(AssetBlob& blob)
+{
+    if (blob.owned) UnloadFileData(blob.owned);
+    blob = AssetBlob();
+}
+
+Image loadAssetImage(const char* name)
+{
+    PROFILE_ZONE("loadAssetImage");
+    AssetBlob blob = readAsset(name);
+    Image img{};
+    if (blob.data) img = LoadImageFromMemory(GetFileExtension(name), blob.data, blob.size);
+    releaseAsset(blob);
+    return img;
+}
+
+Wave loadAssetWave(const char* name)
+{
+    PROFILE_ZONE("loadAssetWave");
+    AssetBlob blob = readAsset(name);
+    Wave wave{};
+    if (blob.data) wave = LoadWaveFromMemory(GetFileExtension(name), blob.data, blob.size);
+    releaseAsset(blob);
+    return wave;
+}
+
+Music loadAssetMusic(const char* name)
+{
+    // Music streams from its data while it plays, which only the archive keeps around.
+    if (const AssetEntry* e = findAsset(name))
+        return LoadMusicStreamFromMemory(GetFileExtension(name), g_assets.data.data() + e->offset, (int)e->size);
+    return LoadMusicStream(looseAssetPath(name).c_str());
+}
+
+std::shared_future<Image> loadAssetImageAsync(const char* name)
+{
+    return std::async(std::launch::async, loadAssetImage, name).share();
+}
+
+std::shared_future<Wave> loadAssetWaveAsync(const char* name)
+{
+    return std::async(std::launch::async, loadAssetWave, name).share();
+}
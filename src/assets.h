@@ -0,0 +1,34 @@
+#pragma once
+
+#include <future>
+
+// assets.pak holds every file the game loads from assets/: a header, an index of names and
+// offsets, then the files back to back. It is read with a single call at startup. Files
+// missing from it, or all of them if there is no archive, are read from assets/ instead.
+constexpr u32 AssetArchiveMagic = 0x4B415053; // "SPAK"
+constexpr u32 AssetArchiveVersion = 1;
+
+struct AssetBlob
+{
+    const u8* data = nullptr;
+    int size = 0;
+    // Set when the bytes came from a loose file.
+    u8* owned = nullptr;
+};
+
+bool openAssetArchive(const char* path);
+// Packs every known asset found in assets/ into path.
+bool writeAssetArchive(const char* path);
+
+bool assetExists(const char* name);
+AssetBlob readAsset(const char* name);
+void releaseAsset(AssetBlob& blob);
+
+Image loadAssetImage(const char* name);
+Wave loadAssetWave(const char* name);
+Music loadAssetMusic(const char* name);
+
+// Decodes on a background thread, name must outlive the load. Creating textures and sounds
+// from the result still has to happen on the main thread.
+std::shared_future<Image> loadAssetImageAsync(const char* name);
+std::shared_future<Wave> loadAssetWaveAsync(const char* name);
@@ -0,0 +1,249 @@
+#include "bench.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "util/random.h"
+
+#include "actor.h"
+#include "jobs.h"
+#include "map.h"
+#include "procgen.h"
+#include "ship.h"
+
+// Allocations made by the calling thread, only read by the benchmark around generate().
+// Per thread and non-atomic so the hook costs the rest of the game next to nothing.
+thread_local u64 t_alloc_count = 0;
+
+void* operator new(size_t size)
+{
+    t_alloc_count++;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+struct Distribution
+{
+    std::vector<double> samples;
+
+    void add(double v) { samples.push_back(v); }
+
+    void print(const char* label)
+    {
+        if (samples.empty()) return;
+        std::sort(samples.begin(), samples.end());
+        double sum = 0.0;
+        for (double v : samples) sum += v;
+        auto at = [&](double p) { return samples[std::min(samples.size() - 1, (size_t)(p * samples.size()))]; };
+        printf("  %-12s min %9.1f  mean %9.1f  p50 %9.1f  p99 %9.1f  max %9.1f\n",
+            label, samples.front(), sum / samples.size(), at(0.5), at(0.99), samples.back());
+    }
+};
+
+struct BenchSample
+{
+    double micros;
+    GenerateStats stats;
+    u64 allocs;
+    int rooms;
+    int engines, torpedoes, pdcs, railguns;
+    bool has_reactor, has_pilot;
+};
+
+void printSamples(const char* title, const std::vector<BenchSample>& samples)
+{
+    Distribution latency, allocs, rooms, engines, torpedoes, pdcs, railguns;
+    int attempts[11]{ 0 };
+    int failures = 0, missing_reactor = 0, missing_pilot = 0;
+    double total_micros = 0.0;
+    for (const BenchSample& s : samples)
+    {
+        total_micros += s.micros;
+        latency.add(s.micros);
+        allocs.add((double)s.allocs);
+        rooms.add(s.rooms);
+        engines.add(s.engines);
+        torpedoes.add(s.torpedoes);
+        pdcs.add(s.pdcs);
+        railguns.add(s.railguns);
+        attempts[std::min(s.stats.attempts, 10)]++;
+        if (!s.stats.success) failures++;
+        if (!s.has_reactor) missing_reactor++;
+        if (!s.has_pilot) missing_pilot++;
+    }
+
+    printf("%s: %d ships, %.1f ships/sec\n", title, (int)samples.size(), samples.size() * 1e6 / total_micros);
+    latency.print("latency us");
+    allocs.print("allocations");
+    rooms.print("rooms");
+    engines.print("engines");
+    torpedoes.print("torpedoes");
+    pdcs.print("pdcs");
+    railguns.print("railguns");
+    printf("  attempts    ");
+    for (int i = 1; i <= 10; ++i) printf(" %d:%d", i, attempts[i]);
+    printf("  failed:%d\n", failures);
+    printf("  missing     reactor:%d pilot:%d\n", missing_reactor, missing_pilot);
+}
+
+int runProcgenBenchmark(int count)
+{
+    const char* types[] = { "player_ship", "cargo_ship", "pirate_ship" };
+    constexpr int type_count = sizeof(types) / sizeof(types[0]);
+
+    loadHullOutlines();
+
+    int failures = 0;
+    std::vector<BenchSample> all;
+    for (int t = 0; t < type_count; ++t)
+    {
+        std::vector<BenchSample> per_type;
+        std::vector<BenchSample> per_outline[HullOutlineCount];
+        for (int o = 0; o < HullOutlineCount; ++o)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                pcg32 rng(0x5EEDull + ((u64)t * HullOutlineCount + o) * count + i);
+                BenchSample s;
+
+                u64 allocs_before = t_alloc_count;
+                auto start = std::chrono::steady_clock::now();
+                Ship* ship = generate("bench", types[t], rng, o, &s.stats);
+                auto end = std::chrono::steady_clock::now();
+
+                s.micros = std::chrono::duration<double, std::micro>(end - start).count();
+                s.allocs = t_alloc_count - allocs_before;
+                s.rooms = (int)ship->rooms.size();
+                // Ship's component lists are only filled by Ship::update, count the placed actors instead.
+                s.engines = s.torpedoes = s.pdcs = s.railguns = 0;
+                s.has_reactor = s.has_pilot = false;
+                for (Actor* a : ship->map->actors)
+                {
+                    switch (a->type)
+                    {
+                    case ActorType::Engine: s.engines++; break;
+                    case ActorType::TorpedoLauncher: s.torpedoes++; break;
+                    case ActorType::PDC: s.pdcs++; break;
+                    case ActorType::Railgun: s.railguns++; break;
+                    case ActorType::Reactor: s.has_reactor = true; break;
+                    case ActorType::PilotSeat: s.has_pilot = true; break;
+                    default: break;
+                    }
+                }
+                if (!s.stats.success) failures++;
+
+                per_outline[o].push_back(s);
+                delete ship->map;
+                delete ship;
+            }
+            per_type.insert(per_type.end(), per_outline[o].begin(), per_outline[o].end());
+        }
+
+        for (int o = 0; o < HullOutlineCount; ++o)
+        {
+            sstring title; title.appendf("%s outline %d", types[t], o);
+            printSamples(title.c_str(), per_outline[o]);
+        }
+        printSamples(types[t], per_type);
+        printf("\n");
+        all.insert(all.end(), per_type.begin(), per_type.end());
+    }
+    printSamples("all", all);
+
+    return failures ? 1 : 0;
+}
+
+// Keeps the optimiser from dropping the kernel's results.
+std::atomic<u64> g_bench_sink = 0;
+
+u64 benchKernel(u64 x)
+{
+    for (int i = 0; i < 256; ++i)
+    {
+        x ^= x >> 33;
+        x *= 0xFF51AFD7ED558CCDull;
+        x ^= x >> 29;
+    }
+    return x;
+}
+
+double timeMillis(const std::chrono::steady_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runJobsBenchmark(int max_threads)
+{
+    if (max_threads <= 0) max_threads = scalar::max(1, (int)std::thread::hardware_concurrency());
+    loadHullOutlines();
+
+    constexpr int KernelCount = 1 << 20;
+    constexpr int ShipCount = 256;
+    constexpr int EmptyJobs = 100000;
+    std::vector<u64> results(KernelCount);
+    std::vector<Ship*> ships(ShipCount);
+
+    printf("%8s %12s %8s %12s %8s %14s\n", "threads", "kernel ms", "speedup", "ships ms", "speedup", "empty job ns");
+    double kernel_base = 0.0, ships_base = 0.0;
+    for (int threads = 1; threads <= max_threads; threads = threads < max_threads && threads * 2 > max_threads ? max_threads : threads * 2)
+    {
+        initJobs(threads);
+
+        auto start = std::chrono::steady_clock::now();
+        parallel_for(0, KernelCount, 1024, [&](int i) { results[i] = benchKernel((u64)i); });
+        double kernel_ms = timeMillis(start);
+        g_bench_sink += results[KernelCount / 2];
+
+        start = std::chrono::steady_clock::now();
+        parallel_for(0, ShipCount, 1, [&](int i)
+        {
+            pcg32 rng(0x5EEDull + i);
+            ships[i] = generate("bench", i % 2 ? "cargo_ship" : "pirate_ship", rng, i % HullOutlineCount);
+        });
+        double ships_ms = timeMillis(start);
+        for (Ship* ship : ships)
+        {
+            delete ship->map;
+            delete ship;
+        }
+
+        JobCounter counter;
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < EmptyJobs; ++i)
+        {
+            Job job;
+            job.fn = [](void*, int, int) {};
+            job.counter = &counter;
+            submitJob(job);
+        }
+        waitJobs(counter);
+        double empty_ns = timeMillis(start) * 1e6 / EmptyJobs;
+
+        if (threads == 1)
+        {
+            kernel_base = kernel_ms;
+            ships_base = ships_ms;
+        }
+        printf("%8d %12.2f %7.2fx %12.2f %7.2fx %14.1f\n", threads, kernel_ms, kernel_base / kernel_ms, ships_ms, ships_base / ships_ms, empty_ns);
+        if (threads == max_threads) break;
+    }
+    initJobs(0);
+    return 0;
+}
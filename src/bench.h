@@ -0,0 +1,9 @@
+#pragma once
+
+// Headless procgen benchmark, run with --bench-procgen [count] from the run_tree directory.
+// Generates count ships of every type on every hull outline and prints a report to stdout.
+int runProcgenBenchmark(int count);
+
+// Job system scaling, run with --bench-jobs [max_threads]. Times parallel_for over a compute
+// kernel and over ship generation at 1, 2, 4... threads, and the cost of empty jobs.
+int runJobsBenchmark(int max_threads);
@@ -1,10 +1,13 @@
 #include "game.h"
 
+#include <algorithm>
 #include <cstdarg>
 
 #include "actor.h"
 #include "map.h"
 #include "procgen.h"
+#include "profiler.h"
+#include "replay.h"
 #include "ship.h"
 #include "universe.h"
 #include "vterm.h"
@@ -12,9 +15,42 @@
 
 Game g_game;
 
+void InfoLog::clear()
+{
+    head = 0;
+    size = 0;
+}
+
+void InfoLog::push(const sstring& msg, u32 color, istring format)
+{
+    if (size > 0)
+    {
+        Entry& last = recent(0);
+        if (last.format == format && last.color == color && last.msg == msg)
+        {
+            last.count++;
+            last.wrap_width = 0;
+            return;
+        }
+    }
+
+    if (size == Capacity)
+        head = (head + 1) % Capacity;
+    else
+        size++;
+
+    // Slots are reused so their strings and line buffers keep their storage.
+    Entry& e = recent(0);
+    e.msg = msg;
+    e.format = format;
+    e.color = color;
+    e.count = 1;
+    e.wrap_width = 0;
+}
+
 void InfoLog::log(const sstring& msg)
 {
-    entries.emplace_back(msg);
+    push(msg, 0xFFFFFFFF);
 }
 
 void InfoLog::logf(const char* fmt, ...)
@@ -24,12 +60,12 @@ void InfoLog::logf(const char* fmt, ...)
     va_start(args, fmt);
     msg.vappend(fmt, args);
     va_end(args);
-    entries.emplace_back(msg);
+    push(msg, 0xFFFFFFFF, istring(fmt));
 }
 
 void InfoLog::log(u32 color, const sstring& msg)
 {
-    entries.emplace_back(msg, color);
+    push(msg, color);
 }
 
 void InfoLog::logf(u32 color, const char* fmt, ...)
@@ -39,24 +75,28 @@ void InfoLog::logf(u32 color, const char* fmt, ...)
     va_start(args, fmt);
     msg.vappend(fmt, args);
     va_end(args);
-    entries.emplace_back(msg, color);
+    push(msg, color, istring(fmt));
 }
 
-std::vector<sstring> smartSplit(const sstring& s, int row_size)
+const std::vector<sstring>& InfoLog::Entry::wrap(int width)
 {
+    if (wrap_width == width) return lines;
+    wrap_width = width;
+    lines.clear();
+
+    sstring s = getMessage();
     int last = 0;
-    std::vector<sstring> rows;
-    while (last < (int)s.size() && (int)s.size() - last > row_size)
+    while (last < (int)s.size() && (int)s.size() - last > width)
     {
-        int prev = s.lastIndexOf(' ', last + row_size);
+        int prev = s.lastIndexOf(' ', last + width);
         if (prev == -1)
-            prev = last + row_size;
-        rows.emplace_back(s.substring(last, prev));
+            prev = last + width;
+        lines.emplace_back(s.substring(last, prev));
         last = prev + 1;
     }
     if (last < (int)s.size())
-        rows.emplace_back(s.substring(last));
-    return rows;
+        lines.emplace_back(s.substring(last));
+    return lines;
 }
 
 char getProjectileCharacter(Direction dir)
@@ -64,142 +104,243 @@ char getProjectileCharacter(Direction dir)
     return " |-/||\\>-\\-^/<v+"[dir];
 }
 
-Animation::Animation() : tick_created(g_game.current_level->turn) {}
-
-ProjectileAnimation::ProjectileAnimation(const vec2i& from, const vec2i& to, u32 color, int c)
-    : from(from), to(to), color(color), character(c)
+bool AnimationSystem::visible() const
 {
-    points = g_game.current_level->findRay(from, to);
-    if (character == 0)
-        character = getProjectileCharacter(getDirection(from, to));
+    return g_game.show_universe == universe_view;
 }
 
-bool ProjectileAnimation::draw()
+void AnimationSystem::clear()
 {
-    if (points.empty())
-        return false;
+    tracks.clear();
+    path.clear();
+    marks.clear();
+}
 
-    vec2i bl = g_game.current_level->player->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    g_game.mapterm->setTile(points[0] - bl, character, color, LayerPriority_Particles);
-    points.erase(points.begin());
-    return !points.empty();
+void AnimationSystem::projectile(vec2i from, vec2i to, u32 color, int character)
+{
+    if (!visible()) return;
+    AnimationTrack& t = tracks.emplace_back();
+    t.type = AnimationType::Projectile;
+    t.start = gameTime();
+    t.color = color;
+    t.character = character ? character : getProjectileCharacter(getDirection(from, to));
+    t.path_first = (int)path.size();
+    frame_vector<vec2i> points = g_game.current_level->findRay(from, to);
+    path.insert(path.end(), points.begin(), points.end());
+    t.path_count = (int)points.size();
 }
 
-RailgunAnimation::RailgunAnimation(u32 color, int c)
-    : color(color), character(c)
+void AnimationSystem::explosion(vec2i center, int radius)
 {
+    if (!visible()) return;
+    AnimationTrack& t = tracks.emplace_back();
+    t.type = AnimationType::Explosion;
+    t.start = gameTime();
+    t.center = center;
+    t.radius = radius;
 }
 
-bool RailgunAnimation::draw()
+void AnimationSystem::shipMove(UShip* ship, vec2i from, vec2i to)
 {
-    vec2i bl = g_game.uplayer->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    if (!hits.empty() && hits[0] == last)
+    if (!visible()) return;
+    AnimationTrack& t = tracks.emplace_back();
+    t.type = AnimationType::ShipMove;
+    t.start = gameTime();
+    t.ship = ship;
+    switch (ship->type)
     {
-        g_game.mapterm->setTile(hits[0] - bl, 'X', 0xFFFF0000, LayerPriority_Particles + 1);
-        hits.erase(hits.begin());
-    }
-    else if (!misses.empty() && misses[0] == last)
+    case UActorType::Player:
+        t.character = '@';
+        t.color = 0xFFFFFFFF;
+        break;
+    case UActorType::CargoShip:
+        t.character = 'C';
+        t.color = 0xFFFFFFFF;
+        break;
+    case UActorType::PirateShip:
+        t.character = 'P';
+        t.color = 0xFFFF0000;
+        break;
+    case UActorType::Torpedo:
     {
-        g_game.mapterm->setTile(misses[0] - bl, 'X', 0xFFFFFFFF, LayerPriority_Particles + 1);
-        misses.erase(misses.begin());
+        t.character = '!';
+        UTorpedo* torp = (UTorpedo*)ship;
+        if (torp->target == g_game.uplayer->id)
+            t.color = 0xFFFF0000;
+        else if (torp->source == g_game.uplayer->id)
+            t.color = 0xFF00FF00;
+        else
+            t.color = 0xFFFFFFFF;
+    } break;
     }
+    t.path_first = (int)path.size();
+    frame_vector<vec2i> points = findRay(from, to);
+    path.insert(path.end(), points.begin(), points.end());
+    t.path_count = (int)points.size();
+    ship->animating = true;
+}
 
-    if (points.empty())
-        return false;
+int AnimationSystem::railgun(u32 color, int character)
+{
+    if (!visible()) return -1;
+    AnimationTrack& t = tracks.emplace_back();
+    t.type = AnimationType::Railgun;
+    t.start = gameTime();
+    t.color = color;
+    t.character = character;
+    t.path_first = (int)path.size();
+    t.mark_first = (int)marks.size();
+    return (int)tracks.size() - 1;
+}
 
-    vec2i p = points[0] - bl;
-    if (p.x < -2 || p.y < -2 || p.x >= g_game.w + 2 || p.y >= g_game.h + 2)
-    {
-        points.clear();
-        return false;
-    }
-    g_game.mapterm->setTile(p, character, color, LayerPriority_Particles);
-    last = points[0];
-    points.erase(points.begin());
-    return !points.empty() || !misses.empty() || !hits.empty();
+void AnimationSystem::addPoint(int track, vec2i p)
+{
+    if (track < 0) return;
+    debug_assert(track == (int)tracks.size() - 1);
+    path.push_back(p);
+    tracks[track].path_count++;
 }
 
-ExplosionAnimation::ExplosionAnimation(vec2i c, int r)
-    : center(c), radius(r)
+void AnimationSystem::addMark(int track, vec2i p, u32 color)
 {
+    if (track < 0) return;
+    debug_assert(track == (int)tracks.size() - 1);
+    AnimationTrack& t = tracks[track];
+    // Marks land on the last matching point of the path so far.
+    int step = t.path_count - 1;
+    while (step > 0 && path[t.path_first + step] != p) --step;
+    marks.push_back(AnimationMark{ step, p, color });
+    t.mark_count++;
+}
 
+void AnimationSystem::addHit(int track, vec2i p)
+{
+    addMark(track, p, 0xFFFF0000);
 }
 
-bool ExplosionAnimation::draw()
+void AnimationSystem::addMiss(int track, vec2i p)
 {
-    if (step > radius + 2)
-        return false;
+    addMark(track, p, 0xFFFFFFFF);
+}
 
-    step += 0.5f;
-    vec2i bl = g_game.current_level->player->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    for (float a = 0; a < 2 * scalar::PIf; a += scalar::PIf / (3 * step))
+// Ring cells for an explosion of the given size, plus the first three cells of the ray from
+// each ring sample back to the center. Duplicates are removed, overlays at one priority are
+// order independent.
+struct ExplosionRing
+{
+    std::vector<vec2i> ring;
+    std::vector<vec2i> ray[3];
+};
+
+void sortUnique(std::vector<vec2i>& v)
+{
+    std::sort(v.begin(), v.end(), [](vec2i a, vec2i b) { return a.y != b.y ? a.y < b.y : a.x < b.x; });
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+}
+
+const ExplosionRing& getExplosionRing(int half_steps)
+{
+    static std::vector<ExplosionRing> rings;
+    if (half_steps >= (int)rings.size())
+        rings.resize(half_steps + 1);
+
+    ExplosionRing& r = rings[half_steps];
+    if (r.ring.empty())
     {
-        vec2i p = center + vec2i(int(cos(a) * step), int(sin(a) * step));
-        std::vector<vec2i> r = findRay(p, center);
-        if (step < radius)
-            g_game.mapterm->setOverlay(p - bl, 0xA0FF8000, LayerPriority_Particles+1);
-        for (int i = 0; i < 3 && i < r.size(); ++i)
-        {
-            if (step - i - 1 < radius)
-                g_game.mapterm->setOverlay(r[i] - bl, 0xD0D0D0D0, LayerPriority_Particles);
-        }
+        float step = half_steps * 0.5f;
+        for (float a = 0; a < 2 * scalar::PIf; a += scalar::PIf / (3 * step))
+        {
+            vec2i p(int(cos(a) * step), int(sin(a) * step));
+            r.ring.push_back(p);
+            frame_vector<vec2i> ray = findRay(p, vec2i());
+            for (int i = 0; i < 3 && i < (int)ray.size(); ++i)
+                r.ray[i].push_back(ray[i]);
+        }
+        sortUnique(r.ring);
+        for (int i = 0; i < 3; ++i)
+            sortUnique(r.ray[i]);
     }
-    return true;
+    return r;
 }
 
-ShipMoveAnimation::ShipMoveAnimation(UShip* s, vec2i f, vec2i t)
-    : ship(s), from(f), to(t)
+bool AnimationSystem::drawTrack(AnimationTrack& t, double now)
 {
-    points = findRay(f, t);
-    switch (s->type)
+    float elapsed = (float)(now - t.start) * AnimationStepsPerSecond;
+    switch (t.type)
     {
-    case UActorType::Player:
-        character = '@';
-        color = 0xFFFFFFFF;
-        break;
-    case UActorType::CargoShip:
-        character = 'C';
-        color = 0xFFFFFFFF;
-        break;
-    case UActorType::PirateShip:
-        character = 'P';
-        color = 0xFFFF0000;
-        break;
-    case UActorType::Torpedo:
+    case AnimationType::Explosion:
     {
-        character = '!';
-        UTorpedo* torp = (UTorpedo*)s;
-        if (torp->target == g_game.uplayer->id)
-            color = 0xFFFF0000;
-        else if (torp->source == g_game.uplayer->id)
-            color = 0xFF00FF00;
-        else
-            color = 0xFFFFFFFF;
-    } break;
+        // Explosions grow half a tile per step.
+        int half_steps = 1 + (int)elapsed;
+        float step = half_steps * 0.5f;
+        if (step > t.radius + 2.5f)
+            return false;
+
+        const ExplosionRing& ring = getExplosionRing(half_steps);
+        vec2i c = t.center - (g_game.current_level->player->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2));
+        if (step < t.radius)
+        {
+            for (vec2i p : ring.ring)
+                g_game.mapterm->setOverlay(c + p, 0xA0FF8000, LayerPriority_Particles + 1);
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            if (step - i - 1 >= t.radius) continue;
+            for (vec2i p : ring.ray[i])
+                g_game.mapterm->setOverlay(c + p, 0xD0D0D0D0, LayerPriority_Particles);
+        }
+        return true;
     }
-    ship->animating = true;
-}
+    case AnimationType::Projectile:
+    case AnimationType::Railgun:
+    case AnimationType::ShipMove:
+    {
+        vec2i origin = t.type == AnimationType::Projectile ? g_game.current_level->player->pos : g_game.uplayer->pos();
+        vec2i bl = origin - vec2i((g_game.w - 30) / 2, g_game.h / 2);
+        int step = (int)elapsed;
 
-ShipMoveAnimation::~ShipMoveAnimation()
-{
-    ship->animating = false;
+        // Marks show for the frame the path moves past them.
+        while (t.mark_cursor < t.mark_count && marks[t.mark_first + t.mark_cursor].step < step)
+        {
+            const AnimationMark& m = marks[t.mark_first + t.mark_cursor];
+            g_game.mapterm->setTile(m.pos - bl, 'X', m.color, LayerPriority_Particles + 1);
+            t.mark_cursor++;
+        }
+
+        if (step >= t.path_count)
+            return t.mark_cursor < t.mark_count;
+
+        vec2i p = path[t.path_first + step] - bl;
+        if (p.x < -2 || p.y < -2 || p.x >= g_game.w + 2 || p.y >= g_game.h + 2)
+            return false;
+        g_game.mapterm->setTile(p, t.character, t.color, LayerPriority_Particles);
+        return true;
+    }
+    }
+    return false;
 }
 
-bool ShipMoveAnimation::draw()
+void AnimationSystem::draw(double now)
 {
-    if (points.empty())
-        return false;
-
-    vec2i bl = g_game.uplayer->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    vec2i p = points[0] - bl;
-    if (p.x < -2 || p.y < -2 || p.x >= g_game.w + 2 || p.y >= g_game.h + 2)
+    size_t n = 0;
+    for (size_t i = 0; i < tracks.size(); ++i)
     {
-        points.clear();
-        return false;
+        AnimationTrack& t = tracks[i];
+        if (drawTrack(t, now))
+        {
+            tracks[n++] = t;
+        }
+        else if (t.type == AnimationType::ShipMove)
+        {
+            t.ship->animating = false;
+        }
+    }
+    tracks.resize(n);
+    if (tracks.empty())
+    {
+        path.clear();
+        marks.clear();
     }
-    g_game.mapterm->setTile(p, character, color, LayerPriority_Particles);
-    points.erase(points.begin());
-    return !points.empty();
 }
 
 struct StationModal : Modal
@@ -213,7 +354,7 @@ struct StationModal : Modal
 
     void draw()
     {
-        if (IsKeyPressed(KEY_ESCAPE))
+        if (inputKeyPressed(KEY_ESCAPE))
         {
             close = true;
             return;
@@ -514,7 +655,7 @@ struct SalvageModal : Modal
 
     void draw()
     {
-        if (IsKeyPressed(KEY_ESCAPE))
+        if (inputKeyPressed(KEY_ESCAPE))
         {
             close = true;
             return;
@@ -651,24 +792,33 @@ void initGame(int w, int h)
     }
 }
 
-void startGame()
+void startGame(u64 seed)
 {
-    g_game.log.entries.clear();
+    g_game.log.clear();
     g_game.log.log("Welcome.");
+    g_game.log.logf(0xFF808080, "Session seed %llu.", (unsigned long long)seed);
 
     if (g_game.universe)
     {
         delete g_game.universe;
     }
     g_game.ships.clear();
+
+    g_game.seed = seed;
+    g_game.frame = 0;
+    g_game.last_scroll_frame = 0;
+    pcg32 root(seed);
+    g_game.rng.setSeed(root.nextLong());
     g_game.universe = new Universe;
-    g_game.player_ship = generate("player", "player_ship");
+    g_game.universe->rng.setSeed(root.nextLong());
+    pcg32 ship_rng(root.nextLong());
+    g_game.player_ship = generate("player", "player_ship", ship_rng);
     g_game.current_level = g_game.player_ship->map;
 
     g_game.uplayer = new UPlayer(vec2i());
     g_game.uplayer->ship = g_game.player_ship;
     g_game.universe->spawn(g_game.uplayer);
-    g_game.universe->update(g_game.uplayer->pos);
+    g_game.universe->update(g_game.uplayer->pos());
 
     g_game.player_ship->update();
     g_game.ships.push_back(g_game.player_ship);
@@ -685,22 +835,26 @@ void startGame()
     g_game.uanimations.clear();
 }
 
+double gameTime()
+{
+    return g_game.frame * GameFrameSeconds;
+}
+
 vec2i game_mouse_pos()
 {
     vec2i bl = g_game.current_level->player->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    return vec2i(GetMouseX() / 16, g_game.h - GetMouseY() / 16) + bl;
+    return vec2i(inputMouseX() / 16, g_game.h - inputMouseY() / 16) + bl;
 }
 
 vec2i universe_mouse_pos()
 {
-    vec2i bl = g_game.uplayer->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-    return vec2i(GetMouseX() / 16, g_game.h - GetMouseY() / 16) + bl;
+    vec2i bl = g_game.uplayer->pos() - vec2i((g_game.w - 30) / 2, g_game.h / 2);
+    return vec2i(inputMouseX() / 16, g_game.h - inputMouseY() / 16) + bl;
 }
 
 vec2f screen_mouse_pos()
 {
-    Vector2 mouse = GetMousePosition();
-    return vec2f(mouse.x / 16, mouse.y / 16);
+    return vec2f(inputMouseX() / 16.0f, inputMouseY() / 16.0f);
 }
 
 void drawUIFrame(TextBuffer* term, vec2i min, vec2i max, const char* title)
@@ -727,15 +881,19 @@ bool drawButton(TextBuffer* term, vec2i pos, const char* label, u32 color, bool
 
     term->write(vec2i(pos.x, pos.y), text.c_str(), col, LayerPriority_UI);
     
-    return !disabled && hovered && IsMouseButtonPressed(MOUSE_BUTTON_LEFT);
+    return !disabled && hovered && inputMousePressed(MOUSE_BUTTON_LEFT);
 }
 
-void updateGame()
+bool updateGame()
 {
+    PROFILE_ZONE("updateGame");
+    g_game.frame++;
+    beginInputFrame();
+
     bool do_map_turn = false;
     int gw = g_game.w - 30;
 
-    if (IsKeyPressed(KEY_ESCAPE))
+    if (inputKeyPressed(KEY_ESCAPE))
     {
         g_game.state = GameState::PauseMenu;
     }
@@ -744,58 +902,57 @@ void updateGame()
     {
         Map& map = *g_game.current_level;
         do_map_turn = map.player->next_action.action != Action::Wait;
-        if (IsKeyPressed(g_game.key_up))
+        if (inputKeyPressed(g_game.key_up))
         {
             do_map_turn = true;
             map.player->tryMove(map, vec2i(0, 1));
         }
-        if (IsKeyPressed(g_game.key_down))
+        if (inputKeyPressed(g_game.key_down))
         {
             do_map_turn = true;
             map.player->tryMove(map, vec2i(0, -1));
         }
-        if (IsKeyPressed(g_game.key_right))
+        if (inputKeyPressed(g_game.key_right))
         {
             do_map_turn = true;
             map.player->tryMove(map, vec2i(1, 0));
         }
-        if (IsKeyPressed(g_game.key_left))
+        if (inputKeyPressed(g_game.key_left))
         {
             do_map_turn = true;
             map.player->tryMove(map, vec2i(-1, 0));
         }
-        if (IsKeyPressed(g_game.key_open))
+        if (inputKeyPressed(g_game.key_open))
         {
             do_map_turn = true;
             map.player->next_action = ActionData(Action::Open, map.player, 1.0f);
         }
-        if (IsKeyPressed(g_game.key_use))
+        if (inputKeyPressed(g_game.key_use))
         {
             do_map_turn = true;
             map.player->next_action = ActionData(Action::UseOn, map.player, 1.0f);
         }
-        if (IsKeyPressed(g_game.key_pickup))
+        if (inputKeyPressed(g_game.key_pickup))
         {
             do_map_turn = true;
             map.player->next_action = ActionData(Action::Pickup, map.player, 1.0f);
         }
-        if (IsKeyPressed(g_game.key_wait))
+        if (inputKeyPressed(g_game.key_wait))
         {
             do_map_turn = true;
             map.player->next_action = ActionData(Action::Wait, map.player, 1.0f);
         }
-        if (GetMouseWheelMove() != 0)
+        if (inputMouseWheel() != 0)
         {
-            static u64 last_scroll = 0;
-            if (g_window.frame_count - last_scroll > 10)
+            if (g_game.frame - g_game.last_scroll_frame > 10)
             {
                 do_map_turn = true;
                 map.player->next_action = ActionData(Action::Wait, map.player, 1.0f);
-                last_scroll = g_window.frame_count;
+                g_game.last_scroll_frame = g_game.frame;
             }
         }
 #if 0
-        if (IsKeyPressed(KEY_X))
+        if (inputKeyPressed(KEY_X))
         {
             vec2i center = (map.max + map.min) / 2;
             vec2i offset = game_mouse_pos() - center;
@@ -805,7 +962,7 @@ void updateGame()
 #endif
 
 #if 0
-        if (IsKeyPressed(KEY_Z))
+        if (inputKeyPressed(KEY_Z))
         {
             if (map.player->is_aiming)
             {
@@ -854,7 +1011,7 @@ void updateGame()
         }
 
         bool do_turn = g_game.modal_close;
-        if (IsKeyPressed(g_game.key_up))
+        if (inputKeyPressed(g_game.key_up))
         {
             if (!engines_functional)
             {
@@ -863,10 +1020,10 @@ void updateGame()
             else
             {
                 do_turn = true;
-                g_game.uplayer->vel += vec2i(0, 1);
+                g_game.uplayer->vel() += vec2i(0, 1);
             }
         }
-        if (IsKeyPressed(g_game.key_down))
+        if (inputKeyPressed(g_game.key_down))
         {
             if (!engines_functional)
             {
@@ -875,10 +1032,10 @@ void updateGame()
             else
             {
                 do_turn = true;
-                g_game.uplayer->vel += vec2i(0, -1);
+                g_game.uplayer->vel() += vec2i(0, -1);
             }
         }
-        if (IsKeyPressed(g_game.key_right))
+        if (inputKeyPressed(g_game.key_right))
         {
             if (!engines_functional)
             {
@@ -887,10 +1044,10 @@ void updateGame()
             else
             {
                 do_turn = true;
-                g_game.uplayer->vel += vec2i(1, 0);
+                g_game.uplayer->vel() += vec2i(1, 0);
             }
         }
-        if (IsKeyPressed(g_game.key_left))
+        if (inputKeyPressed(g_game.key_left))
         {
             if (!engines_functional)
             {
@@ -899,14 +1056,14 @@ void updateGame()
             else
             {
                 do_turn = true;
-                g_game.uplayer->vel += vec2i(-1, 0);
+                g_game.uplayer->vel() += vec2i(-1, 0);
             }
         }
-        if (IsKeyPressed(g_game.key_open))
+        if (inputKeyPressed(g_game.key_open))
         {
             g_game.transition = 1.0f;
         }
-        if (IsKeyPressed(g_game.key_railgun))
+        if (inputKeyPressed(g_game.key_railgun))
         {
             g_game.is_aiming_hail = false;
             g_game.uplayer->is_aiming = false;
@@ -925,7 +1082,7 @@ void updateGame()
                 g_game.uplayer->is_aiming_railgun = true;
             }
         }
-        if (IsKeyPressed(g_game.key_fire))
+        if (inputKeyPressed(g_game.key_fire))
         {
             g_game.is_aiming_hail = false;
             g_game.uplayer->is_aiming_railgun = false;
@@ -944,7 +1101,7 @@ void updateGame()
                 g_game.uplayer->is_aiming = true;
             }
         }
-        if (IsKeyPressed(g_game.key_hail))
+        if (inputKeyPressed(g_game.key_hail))
         {
             g_game.uplayer->is_aiming = false;
             g_game.uplayer->is_aiming_railgun = false;
@@ -963,7 +1120,7 @@ void updateGame()
                 g_game.is_aiming_hail = true;
             }
         }
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        if (inputMousePressed(MOUSE_BUTTON_LEFT))
         {
             if (g_game.uplayer->is_aiming)
             {
@@ -996,15 +1153,15 @@ void updateGame()
                 g_game.is_aiming_hail = false;
             }
         }
-        if (IsKeyPressed(g_game.key_wait))
+        if (inputKeyPressed(g_game.key_wait))
         {
             do_turn = true;
         }
-        if (IsKeyPressed(g_game.key_dock))
+        if (inputKeyPressed(g_game.key_dock))
         {
             for (int i = 0; i < 4; ++i)
             {
-                auto it = g_game.universe->actors.find(g_game.uplayer->pos + cardinals[i]);
+                auto it = g_game.universe->actors.find(g_game.uplayer->pos() + cardinals[i]);
                 if (it.found)
                 {
                     if (it.value->type == UActorType::Station)
@@ -1035,13 +1192,12 @@ void updateGame()
             }
         }
 
-        if (GetMouseWheelMove() != 0)
+        if (inputMouseWheel() != 0)
         {
-            static u64 last_scroll = 0;
-            if (g_window.frame_count - last_scroll > 10)
+            if (g_game.frame - g_game.last_scroll_frame > 10)
             {
                 do_turn = true;
-                last_scroll = g_window.frame_count;
+                g_game.last_scroll_frame = g_game.frame;
             }
         }
 
@@ -1050,7 +1206,7 @@ void updateGame()
             do_map_turn = true;
             g_game.modal_close = false;
             g_game.last_universe_update = g_game.current_level->turn;
-            g_game.universe->update(g_game.uplayer->pos);
+            g_game.universe->update(g_game.uplayer->pos());
         }
 
         if (g_game.uplayer && g_game.uplayer->ship->pilot->status != ShipObject::Status::Active)
@@ -1120,7 +1276,7 @@ void updateGame()
         if (g_game.player_ship->map->turn > g_game.last_universe_update + 10)
         {
             g_game.last_universe_update = g_game.current_level->turn;
-            g_game.universe->update(g_game.uplayer->pos);
+            g_game.universe->update(g_game.uplayer->pos());
         }
         if (g_game.player_ship->hull_integrity <= 0)
         {
@@ -1130,6 +1286,16 @@ void updateGame()
         }
     }
 
+    // Nothing below changes game state unless there was input or something is animating.
+    bool idle = !g_game.redraw && !do_map_turn && !g_game.modal_close && g_game.transition == 0
+        && g_game.animations.empty() && g_game.uanimations.empty();
+    if (g_game.render_on_demand && idle)
+    {
+        endInputFrame();
+        return false;
+    }
+    g_game.redraw = false;
+
     g_game.uiterm->clear(g_game.w, g_game.h);
     g_game.mapterm->clear(g_game.w, g_game.h);
 
@@ -1158,20 +1324,20 @@ void updateGame()
         if (g_game.uplayer->is_aiming || g_game.is_aiming_hail)
         {
             vec2i mouse_pos = universe_mouse_pos();
-            vec2i bl = g_game.uplayer->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
+            vec2i bl = g_game.uplayer->pos() - vec2i((g_game.w - 30) / 2, g_game.h / 2);
             g_game.mapterm->setOverlay(mouse_pos - bl, 0x8000FF00, LayerPriority_Overlay);
         }
         else if (g_game.uplayer->is_aiming_railgun)
         {
             vec2i mouse_pos = universe_mouse_pos();
-            vec2i bl = g_game.uplayer->pos - vec2i((g_game.w - 30) / 2, g_game.h / 2);
-            std::vector<vec2i> steps = findRay(g_game.uplayer->pos, mouse_pos);
+            vec2i bl = g_game.uplayer->pos() - vec2i((g_game.w - 30) / 2, g_game.h / 2);
+            frame_vector<vec2i> steps = findRay(g_game.uplayer->pos(), mouse_pos);
             for (vec2i s: steps)
                 g_game.mapterm->setOverlay(s - bl, 0x8080FF00, LayerPriority_Overlay);
         }
     }
 
-    sstring top_bar;
+    frame_string top_bar;
     if (g_game.show_universe)
     {
         vec2i mouse_pos = universe_mouse_pos();
@@ -1201,7 +1367,8 @@ void updateGame()
                 if (it.value.ground->type == ActorType::GroundItem)
                 {
                     GroundItem* item = (GroundItem*)it.value.ground;
-                    top_bar.appendf("  %s", item->item->getName().c_str());
+                    top_bar.append("  ");
+                    item->item->appendName(top_bar);
                 }
                 else
                 {
@@ -1218,12 +1385,14 @@ void updateGame()
     g_game.uiterm->fillBg(vec2i(0, 0), vec2i(gw - 1, 0), 0xFF101010, LayerPriority_UI - 1);
     g_game.uiterm->write(vec2i(2, 0), top_bar.c_str(), 0xFFFFFFFF, LayerPriority_UI);
 
-    sstring bottom_bar;
-    sstring holding = g_game.current_level->player->holding ? g_game.current_level->player->holding->getName() : sstring("nothing");
-    bottom_bar.appendf("Turn: %d/%d    View: %s    Holding: %s",
+    frame_string bottom_bar;
+    bottom_bar.appendf("Turn: %d/%d    View: %s    Holding: ",
         g_game.current_level->turn, g_game.universe->universe_ticks,
-        g_game.show_universe ? "Universe" : "Ship",
-        holding.c_str());
+        g_game.show_universe ? "Universe" : "Ship");
+    if (g_game.current_level->player->holding)
+        g_game.current_level->player->holding->appendName(bottom_bar);
+    else
+        bottom_bar.append("nothing");
     g_game.uiterm->fillBg(vec2i(0, g_game.h - 1), vec2i(gw - 1, g_game.h - 1), 0xFF101010, LayerPriority_UI - 2);
     g_game.uiterm->write(vec2i(2, g_game.h - 1), bottom_bar.c_str(), 0xFFFFFFFF, LayerPriority_UI);
 
@@ -1244,10 +1413,10 @@ void updateGame()
 
         InfoLog& log = g_game.log;
         int j = 1;
-        for (int i = (int)log.entries.size() - 1; i >= 0 && j < rows; --i)
+        for (int i = 0; i < log.size && j < rows; ++i)
         {
-            auto& e = log.entries[i];
-            auto parts = smartSplit(e.msg, (g_game.w - gw - 2) * 2);
+            InfoLog::Entry& e = log.recent(i);
+            const std::vector<sstring>& parts = e.wrap((g_game.w - gw - 2) * 2);
             for (int k = (int)parts.size() - 1; k >= 0 && j < rows; --k)
             {
                 g_game.uiterm->write(vec2i(gw * 2 + 2, g_game.h - j), parts[k].c_str(), e.color, LayerPriority_UI);
@@ -1271,7 +1440,7 @@ void updateGame()
         Ship* ps = g_game.player_ship;
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Hull: %d", ps->hull_integrity);
             g_game.uiterm->write(vec2i(gw * 2 + 2, y0), line_0.c_str(), 0xFFFFFFFF, LayerPriority_UI);
         }
@@ -1279,21 +1448,21 @@ void updateGame()
         if (ps->pilot)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Pilot [%s]", ShipObjectStatus[int(ps->pilot->status)]);
             g_game.uiterm->write(vec2i(gw * 2 + 2, y0), line_0.c_str(), 0xFFFFFFFF, LayerPriority_UI);
         }
         if (ps->scanner)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Antenna [%s]", ShipObjectStatus[int(ps->pilot->status)]);
             g_game.uiterm->write(vec2i(gw * 2 + 2, y0), line_0.c_str(), 0xFFFFFFFF, LayerPriority_UI);
         }
         if (ps->reactor)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Reactor [%s]", ShipObjectStatus[int(ps->reactor->status)]);
             if (ps->reactor->status == ShipObject::Status::Active)
                 line_0.appendf(" %.0f/%.0f", ps->reactor->power, ps->reactor->capacity);
@@ -1302,14 +1471,14 @@ void updateGame()
         for (MainEngine* e : ps->engines)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Engine [%s]", ShipObjectStatus[int(e->status)]);
             g_game.uiterm->write(vec2i(gw * 2 + 2, y0), line_0.c_str(), 0xFFFFFFFF, LayerPriority_UI);
         }
         for (TorpedoLauncher* e : ps->torpedoes)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Torpedo: [%s]", ShipObjectStatus[int(e->status)]);
             if (ps->reactor->status == ShipObject::Status::Active)
             {
@@ -1322,7 +1491,7 @@ void updateGame()
         for (PDC* e : ps->pdcs)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Point Defence: [%s]", ShipObjectStatus[int(e->status)]);
             if (ps->reactor->status == ShipObject::Status::Active)
             {
@@ -1333,7 +1502,7 @@ void updateGame()
         for (Railgun* e : ps->railguns)
         {
             ++y0;
-            sstring line_0;
+            frame_string line_0;
             line_0.appendf("Railgun: [%s]", ShipObjectStatus[int(e->status)]);
             if (ps->reactor->status == ShipObject::Status::Active)
             {
@@ -1427,40 +1596,16 @@ void updateGame()
     if (g_game.transition == 0)
     {
         if (g_game.show_universe)
-        {
-            for (auto it = g_game.uanimations.begin(); it != g_game.uanimations.end();)
-            {
-                Animation* a = *it;
-                if (!a->draw())
-                {
-                    it = g_game.uanimations.erase(it);
-                    delete a;
-                }
-                else
-                    ++it;
-            }
-        }
+            g_game.uanimations.draw(gameTime());
         else
-        {
-            for (auto it = g_game.animations.begin(); it != g_game.animations.end();)
-            {
-                Animation* a = *it;
-                if (!a->draw())
-                {
-                    it = g_game.animations.erase(it);
-                    delete a;
-                }
-                else
-                    ++it;
-            }
-        }
+            g_game.animations.draw(gameTime());
     }
 
     if (g_game.transition > 0)
     {
         bool past_half = g_game.transition < 0.5f;
         if (past_half ^ g_game.show_universe)
-            g_game.universe->render(*g_game.mapterm, g_game.uplayer->pos);
+            g_game.universe->render(*g_game.mapterm, g_game.uplayer->pos());
         else
             g_game.current_level->render(*g_game.mapterm, g_game.current_level->player->pos);
         g_game.transition -= 0.02f;
@@ -1481,10 +1626,13 @@ void updateGame()
     }
     else if (g_game.show_universe)
     {
-        g_game.universe->render(*g_game.mapterm, g_game.uplayer->pos);
+        g_game.universe->render(*g_game.mapterm, g_game.uplayer->pos());
     }
     else
     {
         g_game.current_level->render(*g_game.mapterm, g_game.current_level->player->pos);
     }
+
+    endInputFrame();
+    return true;
 }
@@ -29,11 +29,14 @@ struct InfoLog
     struct Entry
     {
         sstring msg;
+        // The logf format the message came from, messages from different formats never match.
+        istring format;
         u32 color = 0xFFFFFFFF;
         int count = 1;
 
-        Entry(const sstring& msg) : msg(msg) {}
-        Entry(const sstring& msg, u32 c) : msg(msg), color(c) {}
+        // getMessage() split into rows of at most wrap_width characters, rebuilt when either changes.
+        std::vector<sstring> lines;
+        int wrap_width = 0;
 
         sstring getMessage() const
         {
@@ -42,9 +45,21 @@ struct InfoLog
                 s.appendf(" (x%d)", count);
             return s;
         }
+
+        const std::vector<sstring>& wrap(int width);
     };
 
-    std::vector<Entry> entries;
+    // Fixed size ring, the oldest entry is overwritten once it is full.
+    static constexpr int Capacity = 256;
+    Entry entries[Capacity];
+    int head = 0;
+    int size = 0;
+
+    // i = 0 is the most recent entry.
+    Entry& recent(int i) { return entries[(head + size - 1 - i) % Capacity]; }
+
+    void clear();
+    void push(const sstring& msg, u32 color, istring format = istring());
 
     void log(const sstring& msg);
     void logf(const char* fmt, ...);
@@ -52,74 +67,82 @@ struct InfoLog
     void logf(u32 color, const char* fmt, ...);
 };
 
-struct Animation
+enum class AnimationType
 {
-    int tick_created;
-
-    Animation();
-    virtual ~Animation() {}
-    virtual bool draw() = 0;
+    Projectile,
+    Railgun,
+    Explosion,
+    ShipMove,
 };
 
-struct ProjectileAnimation : Animation
-{
-    vec2i from, to;
-    u32 color;
-    int character;
-
-    std::vector<vec2i> points;
+// Path animations advance this many points per second, explosions half a tile per step.
+constexpr float AnimationStepsPerSecond = 60.0f;
 
-    ProjectileAnimation(const vec2i& from, const vec2i& to, u32 color, int character=0);
+// Length of one game frame. Animations run on game frames rather than wall time so replays
+// see them finish on the same frame.
+constexpr double GameFrameSeconds = 1.0 / 60.0;
 
-    bool draw() override;
-};
-
-char getProjectileCharacter(Direction dir);
-
-struct RailgunAnimation : Animation
+// An 'X' drawn once the animation's path has passed step.
+struct AnimationMark
 {
-    vec2i from, to;
+    int step;
+    vec2i pos;
     u32 color;
-    int character;
-
-    vec2i last;
+};
 
-    std::vector<vec2i> points;
-    std::vector<vec2i> hits;
-    std::vector<vec2i> misses;
+struct AnimationTrack
+{
+    AnimationType type;
+    double start;
+    u32 color = 0xFFFFFFFF;
+    int character = 0;
 
-    RailgunAnimation(u32 color, int c);
+    // Path and marks are ranges in the owning AnimationSystem's buffers.
+    int path_first = 0, path_count = 0;
+    int mark_first = 0, mark_count = 0;
+    int mark_cursor = 0;
 
-    bool draw() override;
+    vec2i center;
+    int radius = 0;
+    UShip* ship = nullptr;
 };
 
-struct ExplosionAnimation : Animation
+// Flat pool of animations for one view. Tracks are compacted in place as they finish and
+// the shared path/mark buffers are rewound whenever the pool drains, so steady state
+// animation does not allocate. Requests made while the view is hidden are dropped.
+struct AnimationSystem
 {
-    vec2i center;
-    int radius;
+    bool universe_view;
 
-    float step = 0.0f;
+    std::vector<AnimationTrack> tracks;
+    std::vector<vec2i> path;
+    std::vector<AnimationMark> marks;
 
-    ExplosionAnimation(vec2i c, int r);
+    AnimationSystem(bool universe_view) : universe_view(universe_view) {}
 
-    bool draw() override;
-};
+    bool visible() const;
+    bool empty() const { return tracks.empty(); }
+    void clear();
 
-struct ShipMoveAnimation : Animation
-{
-    UShip* ship;
-    vec2i from, to;
-    int character;
-    u32 color;
+    void projectile(vec2i from, vec2i to, u32 color, int character = 0);
+    void explosion(vec2i center, int radius);
+    void shipMove(UShip* ship, vec2i from, vec2i to);
 
-    std::vector<vec2i> points;
+    // Starts a railgun track and returns its index, or -1 if the view is hidden. Points
+    // and marks must be added before any other track is started.
+    int railgun(u32 color, int character);
+    void addPoint(int track, vec2i p);
+    void addHit(int track, vec2i p);
+    void addMiss(int track, vec2i p);
 
-    ShipMoveAnimation(UShip* s, vec2i f, vec2i t);
-    virtual ~ShipMoveAnimation();
+    void draw(double now);
 
-    bool draw() override;
+    bool drawTrack(AnimationTrack& t, double now);
+    void addMark(int track, vec2i p, u32 color);
 };
 
+char getProjectileCharacter(Direction dir);
+
 struct Modal
 {
     vec2i pos, size;
@@ -147,6 +170,12 @@ struct Game
 {
     int w=0, h=0;
 
+    // Every rng used by a game is derived from this.
+    u64 seed = 0;
+    // Game frames since startGame, advanced by updateGame.
+    u64 frame = 0;
+    u64 last_scroll_frame = 0;
+
     InfoLog log;
     Registry reg;
     pcg32 rng;
@@ -166,6 +195,11 @@ struct Game
     float transition = 0.0f;
     int last_universe_update = -1000;
 
+    // With render_on_demand the terminals are only recomposed when redraw is set or something
+    // is in motion, idle frames keep showing the last composed frame.
+    bool render_on_demand = false;
+    bool redraw = true;
+
     GameState state = GameState::MainMenu;
     sstring gameover_reason;
 
@@ -190,14 +224,17 @@ struct Game
 
     bool is_aiming_hail = false;
 
-    std::vector<Animation*> animations;
-    std::vector<Animation*> uanimations;
+    AnimationSystem animations{ false };
+    AnimationSystem uanimations{ true };
 };
 extern Game g_game;
 
 void initGame(int w, int h);
-void startGame();
-void updateGame();
+void startGame(u64 seed);
+// Advances one game frame. Returns false if the frame was idle and composing was skipped.
+bool updateGame();
+
+double gameTime();
 
 vec2i game_mouse_pos();
 vec2f screen_mouse_pos();
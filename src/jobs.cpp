@@ -0,0 +1,218 @@
+#include "jobs.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <thread>
+
+#include "util/arena.h"
+#include "util/scalar_math.h"
+
+#include "profiler.h"
+
+// Owner pushes and pops at the back, thieves take from the front. A lock per deque keeps it
+// simple, owners rarely contend with thieves.
+struct JobQueue
+{
+    std::mutex mutex;
+    std::deque<Job> jobs;
+
+    void push(const Job& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        jobs.push_back(job);
+    }
+
+    bool pop(Job& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+
+    bool steal(Job& job)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+};
+
+struct JobSystem
+{
+    int thread_count = 1;
+    // queues[0] belongs to the thread that called initJobs, the rest to the pool threads.
+    // Other threads submit through the shared queue.
+    std::vector<JobQueue*> queues;
+    JobQueue shared;
+    std::vector<std::thread> threads;
+
+    std::atomic<bool> quit = false;
+    std::atomic<int> queued = 0;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+
+    ~JobSystem() { shutdownJobs(); }
+};
+JobSystem g_jobs;
+
+// Index into g_jobs.queues, -1 for threads outside the pool.
+thread_local int job_thread_index = -1;
+
+void finishJob(const Job& job);
+
+void runJob(const Job& job)
+{
+    job.fn(job.data, job.begin, job.end);
+    finishJob(job);
+}
+
+void enqueueJob(const Job& job)
+{
+    if (g_jobs.thread_count <= 1)
+    {
+        runJob(job);
+        return;
+    }
+    int index = job_thread_index;
+    if (index >= 0 && index < (int)g_jobs.queues.size())
+        g_jobs.queues[index]->push(job);
+    else
+        g_jobs.shared.push(job);
+    g_jobs.queued.fetch_add(1, std::memory_order_release);
+    g_jobs.wake.notify_one();
+}
+
+void finishJob(const Job& job)
+{
+    JobCounter* counter = job.counter;
+    if (!counter) return;
+
+    // Decremented under the lock, so a submit racing the last decrement is never lost and
+    // waitJobs can tell when the counter is no longer touched.
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> lock(counter->mutex);
+        if (counter->pending.load(std::memory_order_relaxed) == 1)
+            ready.swap(counter->waiting);
+        counter->pending.fetch_sub(1, std::memory_order_release);
+    }
+    for (const Job& j : ready) enqueueJob(j);
+}
+
+bool findJob(Job& job)
+{
+    int index = job_thread_index;
+    int count = (int)g_jobs.queues.size();
+    if (index >= 0 && index < count && g_jobs.queues[index]->pop(job)) return true;
+    if (g_jobs.shared.steal(job)) return true;
+    // Start with the next queue over so thieves spread out.
+    int start = index >= 0 ? index + 1 : 0;
+    for (int i = 0; i < count; ++i)
+    {
+        int victim = (start + i) % count;
+        if (victim != index && g_jobs.queues[victim]->steal(job)) return true;
+    }
+    return false;
+}
+
+bool tryRunJob()
+{
+    Job job;
+    if (!findJob(job)) return false;
+    g_jobs.queued.fetch_sub(1, std::memory_order_relaxed);
+    runJob(job);
+    return true;
+}
+
+void workerMain(int index)
+{
+    job_thread_index = index;
+    char name[16];
+    snprintf(name, sizeof(name), "job %d", index);
+    profileThreadName(name);
+    while (!g_jobs.quit.load(std::memory_order_acquire))
+    {
+        if (tryRunJob())
+        {
+            frameArena().reset();
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(g_jobs.sleep_mutex);
+        g_jobs.wake.wait_for(lock, std::chrono::milliseconds(2), []()
+        {
+            return g_jobs.quit.load(std::memory_order_acquire) || g_jobs.queued.load(std::memory_order_acquire) > 0;
+        });
+    }
+}
+
+void initJobs(int thread_count)
+{
+    shutdownJobs();
+    if (thread_count <= 0) thread_count = scalar::max(1, (int)std::thread::hardware_concurrency());
+    g_jobs.thread_count = thread_count;
+    g_jobs.quit.store(false, std::memory_order_release);
+    job_thread_index = 0;
+    for (int i = 0; i < thread_count; ++i)
+        g_jobs.queues.push_back(new JobQueue);
+    for (int i = 1; i < thread_count; ++i)
+        g_jobs.threads.emplace_back(workerMain, i);
+}
+
+void shutdownJobs()
+{
+    g_jobs.quit.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(g_jobs.sleep_mutex);
+        g_jobs.wake.notify_all();
+    }
+    for (std::thread& t : g_jobs.threads)
+        t.join();
+    g_jobs.threads.clear();
+    for (JobQueue* q : g_jobs.queues)
+        delete q;
+    g_jobs.queues.clear();
+    g_jobs.thread_count = 1;
+}
+
+int jobThreadCount()
+{
+    return g_jobs.thread_count;
+}
+
+bool jobsInline()
+{
+    return g_jobs.thread_count <= 1;
+}
+
+void submitJob(const Job& job, JobCounter* after)
+{
+    if (job.counter) job.counter->pending.fetch_add(1, std::memory_order_relaxed);
+    if (after)
+    {
+        std::lock_guard<std::mutex> lock(after->mutex);
+        if (!after->done())
+        {
+            after->waiting.push_back(job);
+            return;
+        }
+    }
+    enqueueJob(job);
+}
+
+void waitJobs(JobCounter& counter)
+{
+    PROFILE_ZONE("waitJobs");
+    while (!counter.done())
+    {
+        if (!tryRunJob())
+            std::this_thread::yield();
+    }
+    // The last job may still be releasing the lock, the counter can be destroyed once we get it.
+    std::lock_guard<std::mutex> lock(counter.mutex);
+}
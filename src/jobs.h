@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Work-stealing job system shared by everything that wants other cores. Each worker owns a
+// deque, it runs its own newest jobs first and steals the oldest ones from the others when it
+// runs dry. Threads waiting on a counter run jobs while they wait.
+//
+// Jobs must not keep frame arena allocations: pool threads reset their arena after every job.
+
+struct Job;
+
+// Counts unfinished jobs. Jobs submitted with it as a dependency start once it reaches zero.
+struct JobCounter
+{
+    std::atomic<int> pending = 0;
+
+    std::mutex mutex;
+    std::vector<Job> waiting;
+
+    bool done() const { return pending.load(std::memory_order_acquire) == 0; }
+};
+
+struct Job
+{
+    void (*fn)(void* data, int begin, int end) = nullptr;
+    void* data = nullptr;
+    int begin = 0, end = 0;
+    JobCounter* counter = nullptr;
+};
+
+// Restarts the pool with thread_count threads including the caller, 0 uses every core. With a
+// single thread every job runs inline when submitted, in submission order. Must be called while
+// no jobs are running.
+void initJobs(int thread_count);
+void shutdownJobs();
+int jobThreadCount();
+bool jobsInline();
+
+// Runs fn(data, begin, end). counter, if set, is incremented now and decremented once the job
+// has run. after, if set, delays the job until that counter reaches zero.
+void submitJob(const Job& job, JobCounter* after = nullptr);
+// Runs other jobs until counter reaches zero. A counter may only be destroyed after this returns.
+void waitJobs(JobCounter& counter);
+
+// Runs a copy of fn() as one job.
+template<typename F>
+void submitTask(F&& fn, JobCounter* counter = nullptr, JobCounter* after = nullptr)
+{
+    using Fn = std::decay_t<F>;
+    Job job;
+    job.fn = [](void* data, int, int)
+    {
+        Fn* f = (Fn*)data;
+        (*f)();
+        delete f;
+    };
+    job.data = new Fn(std::forward<F>(fn));
+    job.counter = counter;
+    submitJob(job, after);
+}
+
+// Calls fn(i) for every i in [begin, end), split into jobs of grain indices, and returns once
+// all of them have run. Inline mode runs them in order on the calling thread.
+template<typename F>
+void parallel_for(int begin, int end, int grain, const F& fn)
+{
+    if (begin >= end) return;
+    if (grain < 1) grain = 1;
+    if (jobsInline() || end - begin <= grain)
+    {
+        for (int i = begin; i < end; ++i) fn(i);
+        return;
+    }
+
+    JobCounter counter;
+    for (int b = begin; b < end; b += grain)
+    {
+        Job job;
+        job.fn = [](void* data, int first, int last)
+        {
+            const F& f = *(const F*)data;
+            for (int i = first; i < last; ++i) f(i);
+        };
+        job.data = (void*)&fn;
+        job.begin = b;
+        job.end = b + grain < end ? b + grain : end;
+        job.counter = &counter;
+        submitJob(job);
+    }
+    waitJobs(counter);
+}
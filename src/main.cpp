@@ -1,14 +1,40 @@
 
+#include <atomic>
+#include <chrono>
 #include <cstdio>
+#include <thread>
 
+#include "util/arena.h"
+
+#include "assets.h"
+#include "bench.h"
 #include "game.h"
+#include "jobs.h"
 #include "map.h"
+#include "procgen.h"
+#include "profiler.h"
+#include "replay.h"
+#include "save.h"
+#include "snapshot.h"
 #include "sound.h"
+#include "tty.h"
 #include "vterm.h"
 #include "universe.h"
 #include "window.h"
 
-bool want_close = false;
+std::atomic<bool> want_close = false;
+
+// --seed fixes the seed of every new game, --record logs every new game's input to record_path.
+bool fixed_seed = false;
+u64 session_seed = 0;
+const char* record_path = nullptr;
+
+void newGame()
+{
+    g_game.state = GameState::Ingame;
+    startGame(fixed_seed ? session_seed : pcg32().nextLong());
+    if (record_path) startRecording(record_path);
+}
 
 void readSettings()
 {
@@ -50,6 +76,8 @@ void readSettings()
             g_game.key_wait = atoi(parts[1].c_str());
         else if (parts[0] == "key_hail")
             g_game.key_hail = atoi(parts[1].c_str());
+        else if (parts[0] == "render_on_demand")
+            g_game.render_on_demand = atoi(parts[1].c_str()) != 0;
     }
 }
 
@@ -70,6 +98,7 @@ void writeSettings()
     s.appendf("key_pickup=%d\n", g_game.key_pickup);
     s.appendf("key_wait=%d\n", g_game.key_wait);
     s.appendf("key_hail=%d\n", g_game.key_hail);
+    s.appendf("render_on_demand=%d\n", g_game.render_on_demand ? 1 : 0);
 
     SaveFileText("settings.ini", s.mut_str());
 }
@@ -86,8 +115,7 @@ void drawMenu(TextBuffer& buf)
 {
     if (drawButton(&buf, vec2i(g_game.w + 5, g_game.h - 9), "Start Game", 0xFFFFFFFF))
     {
-        g_game.state = GameState::Ingame;
-        startGame();
+        newGame();
     }
     if (drawButton(&buf, vec2i(g_game.w + 5, g_game.h - 8), "Settings", 0xFFFFFFFF))
     {
@@ -109,7 +137,7 @@ void drawSlider(TextBuffer& buf, vec2i pos, int& value, const char* label)
     vec2f mouse = screen_mouse_pos();
     bool hovered = mouse.x >= pos.x / 2.0f && mouse.x < (pos.x + 11) / 2.0f && scalar::floori(mouse.y) == pos.y;
     u32 col = hovered ? 0xFF00FF00 : 0xFFFFFFFF;
-    if (hovered && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    if (hovered && inputMousePressed(MOUSE_BUTTON_LEFT))
     {
         value = scalar::clamp(scalar::floori((mouse.x - pos.x / 2.0f) * 2.0f), 0, 10);
     }
@@ -128,18 +156,18 @@ void keySelector(TextBuffer& buf, vec2i pos, int& key, const char* label)
 
     if (waiting_for == &key)
     {
-        if (IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+        if (inputMousePressed(MOUSE_BUTTON_LEFT))
         {
             waiting_for = nullptr;
         }
-        int k = GetKeyPressed();
+        int k = inputGetKeyPressed();
         if (k != 0)
         {
             waiting_for = nullptr;
             key = k;
         }
     }
-    else if (hovered && IsMouseButtonPressed(MOUSE_BUTTON_LEFT))
+    else if (hovered && inputMousePressed(MOUSE_BUTTON_LEFT))
     {
         waiting_for = &key;
     }
@@ -193,8 +221,7 @@ void drawGameOver(TextBuffer& buf)
 
     if (drawButton(&buf, vec2i(g_game.w + 5, g_game.h - 5), "New Game", 0xFFFFFFFF))
     {
-        g_game.state = GameState::Ingame;
-        startGame();
+        newGame();
     }
     if (drawButton(&buf, vec2i(g_game.w + 5, g_game.h - 4), "Settings", 0xFFFFFFFF))
     {
@@ -223,88 +250,116 @@ void drawGameOver(TextBuffer& buf)
     buf.write(vec2i(g_game.w + 45, g_game.h - 3), line0.c_str(), 0xFFFFFFFF);
 }
 
-int main(int argc, const char** argv)
-{
-    int w = 80;
-    int h = 45;
+// F4 writes the trace history here, --trace also writes it on exit.
+const char* trace_path = "trace.json";
 
-    int scale = 16;
+// Owned by whichever thread runs simulateFrame.
+TextBuffer* menuterm = nullptr;
+TextBuffer* debugterm = nullptr;
+int menu_frame = 0;
+vec2i menu_ship_pos = vec2i(0, 0);
 
-    initGame(w, h);
-    readSettings();
-    window_open("7drl - Salvage Scramble", w * scale, h * scale);
+SnapshotBuffer snapshots;
+u64 sim_ticks = 0;
+// Sim ticks that composed nothing and render frames that presented nothing, in on demand mode.
+u64 compose_skipped = 0;
+u64 present_skipped = 0;
+std::atomic<bool> sim_quit = false;
+
+// A tick that falls further behind than this drops the backlog rather than racing to catch up.
+constexpr int SimMaxCatchUpTicks = 5;
+// In on demand mode an unchanged frame is still presented this often.
+constexpr double PresentKeepAliveSeconds = 0.5;
 
-    Image img = LoadImage("assets/ship_cover.png");
-    if (!img.data)
+void handleHotkeys()
+{
+    if (inputKeyPressed(KEY_F3))
+        g_profiler.overlay = !g_profiler.overlay;
+    if (inputKeyPressed(KEY_F4))
     {
-        while (!WindowShouldClose())
+        if (writeChromeTrace(trace_path))
+            g_game.log.logf(0xFFFFFF00, "Wrote trace to %s", trace_path);
+        else
+            g_game.log.logf(0xFFFF0000, "Failed to write trace to %s", trace_path);
+    }
+    if (inputKeyPressed(KEY_F5) && g_game.state == GameState::Ingame && !g_game.modal)
+    {
+        double start = GetTime();
+        if (saveGame("save.dat"))
+            g_game.log.logf(0xFFFFFF00, "Game saved (%.1f ms).", (GetTime() - start) * 1000.0);
+        else
+            g_game.log.log(0xFFFF0000, "Failed to save the game.");
+    }
+    if (inputKeyPressed(KEY_F9) && (g_game.state == GameState::Ingame || g_game.state == GameState::MainMenu || g_game.state == GameState::GameOver))
+    {
+        double start = GetTime();
+        if (loadGame("save.dat"))
         {
-            BeginDrawing();
-            ClearBackground(BLACK);
-            DrawText("Missing assets?", 100, h * scale / 2, 64, WHITE);
-            EndDrawing();
+            // The recording cannot reproduce the loaded state, so it ends here.
+            stopRecording();
+            g_game.log.logf(0xFFFFFF00, "Game loaded (%.1f ms).", (GetTime() - start) * 1000.0);
         }
-        return -1;
+        else
+            g_game.log.log(0xFFFF0000, "Failed to load save.dat.");
     }
+}
 
-    SetExitKey(0);
-
-    g_game.state = GameState::MainMenu;
-    TextBuffer* menuterm = new TextBuffer(w, h);
-
-    g_game.universe = new Universe;
+// One sim tick: consumes the queued input, advances the game and composes every terminal,
+// then publishes them as a snapshot. Makes no raylib drawing calls. In render on demand mode
+// an idle tick composes nothing and publishes nothing.
+void simulateFrame()
+{
+    ProfileScope frame_zone("frame");
+
+    InputFrame& input = g_input.frame;
+    s16 last_x = input.mouse_x, last_y = input.mouse_y;
+    u8 last_w = input.w, last_h = input.h;
+    GameState last_state = g_game.state;
+    input.clearPresses();
+    while (g_input.queue.pop(input)) {}
+    if (input.w > 0 && input.h > 0)
+    {
+        g_game.w = input.w;
+        g_game.h = input.h;
+    }
 
-    int menu_frame = 0;
-    vec2i menu_ship_pos = vec2i(0, 0);
+    updateSounds();
+    handleHotkeys();
 
-    Texture menu_tex = LoadTextureFromImage(img);
-    UnloadImage(img);
+    // Buttons highlight under the mouse, so moving it is enough to need a new frame.
+    if (!input.empty() || input.mouse_x != last_x || input.mouse_y != last_y || input.w != last_w || input.h != last_h
+        || g_game.state != last_state || g_profiler.overlay || !g_game.render_on_demand)
+        g_game.redraw = true;
+    bool composed = g_game.redraw;
 
-    initSounds();
+    RenderSnapshot& snap = snapshots.back();
+    snap.draw_ui = false;
+    snap.draw_menu = false;
 
-    while (!WindowShouldClose() && !want_close)
+    if (g_game.state == GameState::Ingame)
     {
-        updateSounds();
-
-        BeginDrawing();
-
-        g_window.width = GetScreenWidth();
-        g_window.height = GetScreenHeight();
-
-        g_game.w = GetScreenWidth() / 16;
-        g_game.h = GetScreenHeight() / 16;
+        composed = updateGame();
+    }
 
-        if (g_game.state == GameState::Ingame)
-        {
-            updateGame();
-        }
+    if (g_game.state == GameState::Ingame || g_game.state == GameState::PauseMenu || g_game.state == GameState::GameOver || g_game.state == GameState::Victory)
+    {
+        snap.menu_scene = false;
+        snap.draw_ui = g_game.state == GameState::Ingame;
 
-        if (g_game.state == GameState::Ingame || g_game.state == GameState::PauseMenu || g_game.state == GameState::GameOver || g_game.state == GameState::Victory)
+        if (g_game.state == GameState::PauseMenu || g_game.state == GameState::GameOver || g_game.state == GameState::Victory)
         {
-            int dw = g_window.width - g_game.w * 16;
-            int dh = g_window.height - g_game.h * 16;
-
-            ClearBackground(BLACK);
-            BeginScissorMode(dw / 2, dh / 2, g_game.w * 16, g_game.h * 16);
-
-            render_buffer(g_game.mapterm, g_window.map_zoom);
-            if (g_game.state == GameState::Ingame)
-                render_buffer(g_game.uiterm, 1.0f);
-
-            if (g_game.state == GameState::PauseMenu || g_game.state == GameState::GameOver || g_game.state == GameState::Victory)
+            menu_frame++;
+            if (composed)
             {
-                menu_frame++;
                 menuterm->clear(g_game.w, g_game.h);
-                Rectangle dest{ dw / 2.0f, dh / 2.0f, g_game.w * 16.0f, g_game.h * 16.0f };
-                Rectangle src{ 0.0f, 0.0f, (float)menu_tex.width, (float)menu_tex.height };
-                DrawTexturePro(menu_tex, src, dest, Vector2(), 0.0f, WHITE);
+                snap.draw_menu = true;
 
                 drawTitle(*menuterm);
 
                 if (g_game.state == GameState::PauseMenu)
                 {
                     drawSettings(*menuterm);
-                    if (menu_frame > 1 && IsKeyPressed(KEY_ESCAPE))
+                    if (menu_frame > 1 && inputKeyPressed(KEY_ESCAPE))
                     {
                         g_game.state = GameState::Ingame;
                     }
@@ -326,48 +381,41 @@ int main(int argc, const char** argv)
                 {
                     drawGameOver(*menuterm);
                 }
-
-                render_buffer(menuterm, 1.0f);
             }
-            else
-            {
-                menu_frame = 0;
-            }
-
-            EndScissorMode();
         }
-        else if (g_game.state == GameState::MainMenu || g_game.state == GameState::Settings)
+        else
         {
-            if (g_game.uplayer)
-            {
-                delete g_game.universe;
-                g_game.universe = new Universe;
-                g_game.uplayer = nullptr;
-                g_game.ships.clear();
-                g_game.current_level = nullptr;
-                g_game.player_ship = nullptr;
-            }
+            menu_frame = 0;
+        }
+    }
+    else if (g_game.state == GameState::MainMenu || g_game.state == GameState::Settings)
+    {
+        if (g_game.uplayer)
+        {
+            delete g_game.universe;
+            g_game.universe = new Universe;
+            g_game.uplayer = nullptr;
+            g_game.ships.clear();
+            g_game.current_level = nullptr;
+            g_game.player_ship = nullptr;
+        }
 
+        menu_frame++;
+        if ((menu_frame % 5) == 0)
+        {
+            menu_ship_pos += vec2i(1, 0);
+            g_game.universe->update(menu_ship_pos);
+            composed = true;
+        }
+
+        if (composed)
+        {
+            snap.menu_scene = true;
+            snap.draw_menu = true;
             menuterm->clear(g_game.w, g_game.h);
-            int dw = g_window.width - g_game.w * 16;
-            int dh = g_window.height - g_game.h * 16;
-            ClearBackground(Color{0x20, 0x20, 0x20, 0xFF});
 
             g_game.mapterm->clear(g_game.w, g_game.h);
-            menu_frame++;
-            if ((menu_frame % 5) == 0)
-            {
-                menu_ship_pos += vec2i(1, 0);
-                g_game.universe->update(menu_ship_pos);
-            }
             g_game.universe->render(*g_game.mapterm, menu_ship_pos);
-            render_buffer(g_game.mapterm, g_window.map_zoom);
-
-            Rectangle dest{ dw / 2.0f, dh / 2.0f, g_game.w * 16.0f, g_game.h * 16.0f };
-            Rectangle src{ 0.0f, 0.0f, (float) menu_tex.width, (float) menu_tex.height };
-            DrawTexturePro(menu_tex, src, dest, Vector2(), 0.0f, WHITE);
-
-            BeginScissorMode(dw / 2, dh / 2, g_game.w * 16, g_game.h * 16);
 
             drawTitle(*menuterm);
 
@@ -384,16 +432,302 @@ int main(int argc, const char** argv)
                     g_game.state = GameState::MainMenu;
                 }
             }
+        }
+    }
+    g_game.redraw = false;
+
+    if (composed)
+    {
+        PROFILE_ZONE("publishSnapshot");
+        snap.draw_debug = g_profiler.overlay;
+        if (snap.draw_debug)
+        {
+            debugterm->clear(g_game.w, g_game.h);
+            drawProfiler(*debugterm);
+        }
 
-            render_buffer(menuterm, 1.0f);
+        snap.tick = ++sim_ticks;
+        snap.w = g_game.w;
+        snap.h = g_game.h;
+        snap.map_zoom = g_window.map_zoom;
+        snap.map.copyFrom(*g_game.mapterm);
+        if (snap.draw_ui) snap.ui.copyFrom(*g_game.uiterm);
+        if (snap.draw_menu) snap.menu.copyFrom(*menuterm);
+        if (snap.draw_debug) snap.debug.copyFrom(*debugterm);
+        snapshots.publish();
+    }
+    else
+    {
+        compose_skipped++;
+    }
+
+    frame_zone.end();
+    Arena& arena = frameArena();
+    profileCounter("frame_arena_bytes", (s64)(arena.used + arena.overflow_bytes));
+    profileCounter("frame_arena_overflows", (s64)arena.overflow_count);
+    profileCounter("compose_skipped", (s64)compose_skipped);
+    arena.reset();
+    profilerFrame();
+}
 
-            EndScissorMode();
+// Runs simulateFrame every GameFrameSeconds until sim_quit, independent of the render rate.
+void simMain()
+{
+    profileThreadName("sim");
+    using clock = std::chrono::steady_clock;
+    clock::duration step = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(GameFrameSeconds));
+    clock::time_point next = clock::now();
+    while (!sim_quit.load(std::memory_order_acquire))
+    {
+        clock::time_point now = clock::now();
+        if (now < next)
+        {
+            std::this_thread::sleep_until(next);
+            continue;
         }
+        if (now - next > step * SimMaxCatchUpTicks)
+            next = now;
+        next += step;
+        simulateFrame();
+    }
+}
 
-        EndDrawing();
+// Input the sim thread has not taken yet, presses pile up here while its queue is full.
+InputFrame pending_input;
+bool pending_presses = false;
+
+void queueInput(const InputFrame& input)
+{
+    if (!pending_presses) pending_input.clearPresses();
+    pending_input.merge(input);
+    pending_presses = !g_input.queue.push(pending_input);
+}
+
+void windowLoop(bool sim_inline, bool on_demand)
+{
+    // Decoding runs in the background while the menu is up, the first ship generated waits
+    // for the hull outlines and sounds stay silent until their waves are ready.
+    std::shared_future<Image> menu_img = loadAssetImageAsync("ship_cover.png");
+    Texture menu_tex{};
+    double last_present = 0.0;
+
+    while (!WindowShouldClose() && !want_close)
+    {
+        ProfileScope frame_zone("render");
+
+        bool present = !on_demand;
+        if (menu_img.valid() && menu_img.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+        {
+            Image img = menu_img.get();
+            menu_tex = LoadTextureFromImage(img);
+            UnloadImage(img);
+            menu_img = std::shared_future<Image>();
+            present = true;
+        }
+
+        g_window.width = GetScreenWidth();
+        g_window.height = GetScreenHeight();
+
+        InputFrame input;
+        captureInputFrame(input);
+        input.w = (u8)scalar::min(g_window.width / 16, 255);
+        input.h = (u8)scalar::min(g_window.height / 16, 255);
+        queueInput(input);
+
+        if (sim_inline)
+            simulateFrame();
+
+        double now = GetTime();
+        if (present || snapshots.fresh() || now - last_present >= PresentKeepAliveSeconds)
+        {
+            BeginDrawing();
+            drawRenderSnapshot(snapshots.latest(), menu_tex);
+            EndDrawing();
+            last_present = now;
+        }
+        else
+        {
+            // EndDrawing normally polls input and paces the loop.
+            present_skipped++;
+            PollInputEvents();
+            WaitTime(GameFrameSeconds);
+        }
+        profileCounter("present_skipped", (s64)present_skipped);
+
+        frame_zone.end();
+        if (!sim_inline)
+            frameArena().reset();
+    }
+}
+
+// Only new snapshots are drawn, and only their changed cells are written.
+void terminalLoop(bool sim_inline)
+{
+    std::chrono::duration<double> frame(GameFrameSeconds);
+    while (!want_close)
+    {
+        ProfileScope frame_zone("render");
+
+        InputFrame input;
+        if (!ttyPollInput(input))
+            want_close = true;
+        vec2i size = ttySize();
+        input.w = (u8)scalar::clamp(size.x, 1, 255);
+        input.h = (u8)scalar::clamp(size.y, 1, 255);
+        queueInput(input);
+
+        if (sim_inline)
+            simulateFrame();
+
+        if (snapshots.fresh())
+            ttyPresent(snapshots.latest());
+
+        frame_zone.end();
+        if (!sim_inline)
+            frameArena().reset();
+        std::this_thread::sleep_for(frame);
+    }
+}
+
+int main(int argc, const char** argv)
+{
+    int w = 80;
+    int h = 45;
+
+    int scale = 16;
+
+    // Also the render thread once the sim has its own.
+    profileThreadName("main");
+    initGame(w, h);
+    openAssetArchive("assets.pak");
+    initJobs(0);
+
+    bool trace_on_exit = false;
+    // --sim-inline runs one sim tick per rendered frame on the main thread, as before the sim thread.
+    bool sim_inline = false;
+    // --on-demand, or render_on_demand=1 in settings.ini, only draws frames that changed.
+    bool on_demand = false;
+    // --tty plays in the terminal instead of a window.
+    bool terminal = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strings::equals(argv[i], "--bench-procgen"))
+        {
+            int count = i + 1 < argc && strings::isInteger(argv[i + 1]) ? atoi(argv[i + 1]) : 100;
+            return runProcgenBenchmark(scalar::max(count, 1));
+        }
+        else if (strings::equals(argv[i], "--bench-jobs"))
+        {
+            return runJobsBenchmark(i + 1 < argc && strings::isInteger(argv[i + 1]) ? atoi(argv[i + 1]) : 0);
+        }
+        else if (strings::equals(argv[i], "--threads") && i + 1 < argc)
+        {
+            // 1 runs every job inline in submission order, for debugging.
+            initJobs(atoi(argv[++i]));
+        }
+        else if (strings::equals(argv[i], "--pack-assets"))
+        {
+            return writeAssetArchive(i + 1 < argc ? argv[i + 1] : "assets.pak") ? 0 : 1;
+        }
+        else if (strings::equals(argv[i], "--sim-inline"))
+        {
+            sim_inline = true;
+        }
+        else if (strings::equals(argv[i], "--on-demand"))
+        {
+            on_demand = true;
+        }
+        else if (strings::equals(argv[i], "--tty"))
+        {
+            terminal = true;
+        }
+        else if (strings::equals(argv[i], "--trace"))
+        {
+            if (i + 1 < argc && argv[i + 1][0] != '-') trace_path = argv[++i];
+            trace_on_exit = true;
+        }
+        else if (strings::equals(argv[i], "--seed") && i + 1 < argc)
+        {
+            fixed_seed = true;
+            session_seed = strtoull(argv[++i], nullptr, 10);
+        }
+        else if (strings::equals(argv[i], "--record") && i + 1 < argc)
+        {
+            record_path = argv[++i];
+        }
+        else if (strings::equals(argv[i], "--replay") && i + 1 < argc)
+        {
+            return runReplay(argv[i + 1]);
+        }
+    }
+
+    readSettings();
+    if (on_demand)
+        g_game.render_on_demand = true;
+    on_demand = g_game.render_on_demand;
+
+    if (terminal)
+    {
+        // raylib logs to stdout, which is now the screen.
+        SetTraceLogLevel(LOG_NONE);
+        if (!ttyOpen())
+        {
+            printf("--tty needs stdin and stdout to be a terminal\n");
+            return 1;
+        }
+    }
+    else
+    {
+        window_open("7drl - Salvage Scramble", w * scale, h * scale);
+
+        if (!assetExists("ship_cover.png"))
+        {
+            while (!WindowShouldClose())
+            {
+                BeginDrawing();
+                ClearBackground(BLACK);
+                DrawText("Missing assets?", 100, h * scale / 2, 64, WHITE);
+                EndDrawing();
+            }
+            return -1;
+        }
+
+        SetExitKey(0);
     }
 
+    g_game.state = GameState::MainMenu;
+    menuterm = new TextBuffer(w, h);
+    debugterm = new TextBuffer(w, h);
+
+    g_game.universe = new Universe;
+
+    initSounds(terminal ? SoundBackend::Null : SoundBackend::Audio);
+    loadHullOutlinesAsync();
+
+    // From here on g_game belongs to the sim thread, this thread only polls input and draws
+    // the latest snapshot, so a slow tick no longer stalls rendering.
+    g_input.queued = true;
+    std::thread sim;
+    if (!sim_inline)
+        sim = std::thread(simMain);
+
+    if (terminal)
+        terminalLoop(sim_inline);
+    else
+        windowLoop(sim_inline, on_demand);
+
+    sim_quit = true;
+    if (sim.joinable())
+        sim.join();
+    g_input.queued = false;
+
+    if (terminal)
+        ttyClose();
     writeSettings();
+    stopRecording();
+    if (trace_on_exit)
+        writeChromeTrace(trace_path);
 
     return 0;
-}
\ No newline at end of file
+}
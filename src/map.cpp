@@ -4,6 +4,7 @@
 
 #include "actor.h"
 #include "game.h"
+#include "profiler.h"
 
 Map::Map(const sstring& name)
     : name(name)
@@ -12,6 +13,7 @@ Map::Map(const sstring& name)
 
 void Map::render(TextBuffer& buffer, vec2i origin)
 {
+    PROFILE_ZONE("Map::render");
     vec2i bl = origin - vec2i((g_game.w - 30) / 2, g_game.h / 2);
 
     linear_map<vec2i, bool> los;
@@ -288,7 +290,7 @@ std::vector<vec2i> Map::findPath(vec2i from, vec2i to)
     return result;
 }
 
-std::vector<vec2i> Map::findRay(vec2i from, vec2i to)
+frame_vector<vec2i> Map::findRay(vec2i from, vec2i to)
 {
     float x0 = from.x + 0.5f;
     float y0 = from.y + 0.5f;
@@ -309,7 +311,7 @@ std::vector<vec2i> Map::findRay(vec2i from, vec2i to)
     dx *= 2;
     dy *= 2;
 
-    std::vector<vec2i> result;
+    frame_vector<vec2i> result;
     for (; n > 0; --n)
     {
         result.push_back(vec2i(x, y));
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "util/arena.h"
 #include "util/linear_map.h"
 #include "util/string.h"
 #include "util/vector_math.h"
@@ -52,7 +53,7 @@ struct Map
     vec2i findNearestEmpty(vec2i p, Terrain trr, int max = 3);
 
     std::vector<vec2i> findPath(vec2i from, vec2i to);
-    std::vector<vec2i> findRay(vec2i from, vec2i to);
+    frame_vector<vec2i> findRay(vec2i from, vec2i to);
 
     bool isVisible(vec2i from, vec2i to);
 };
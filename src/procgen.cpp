@@ -1,13 +1,19 @@
 #include "procgen.h"
 
+#include <atomic>
+#include <bit>
 #include <deque>
+#include <future>
 #include <vector>
 
 #include "util/random.h"
 
 #include "actor.h"
+#include "assets.h"
 #include "game.h"
+#include "jobs.h"
 #include "map.h"
+#include "profiler.h"
 #include "ship.h"
 
 #if 0
@@ -612,10 +618,99 @@ struct ShipParameters
     int max_railguns = 2;
 };
 
+const char* hull_outline_assets[HullOutlineCount]
+{
+    "ship_0.png",
+    "ship_1.png",
+    "ship_2.png",
+    "ship_3.png",
+    "ship_4.png",
+    "ship_5.png",
+    "ship_6.png",
+};
+HullOutline hull_outlines[HullOutlineCount];
+std::atomic<bool> hull_outlines_loaded = false;
+std::shared_future<void> hull_outlines_future;
+
+int HullOutline::count(int y, int x0, int x1) const
+{
+    if (y < 0 || y >= h) return 0;
+    const Span& span = spans[y];
+    x0 = scalar::max(x0, (int)span.first);
+    x1 = scalar::min(x1, (int)span.last);
+    if (x0 > x1) return 0;
+
+    const u64* row = &bits[y * stride];
+    int w0 = x0 >> 6;
+    int w1 = x1 >> 6;
+    u64 lo_mask = ~0ull << (x0 & 63);
+    u64 hi_mask = ~0ull >> (63 - (x1 & 63));
+    if (w0 == w1)
+        return std::popcount(row[w0] & lo_mask & hi_mask);
+
+    int c = std::popcount(row[w0] & lo_mask);
+    for (int i = w0 + 1; i < w1; ++i)
+        c += std::popcount(row[i]);
+    c += std::popcount(row[w1] & hi_mask);
+    return c;
+}
+
+void decodeHullOutlines()
+{
+    PROFILE_ZONE("decodeHullOutlines");
+    for (int i = 0; i < HullOutlineCount; ++i)
+    {
+        HullOutline& o = hull_outlines[i];
+        Image img = loadAssetImage(hull_outline_assets[i]);
+        Color* colors = LoadImageColors(img);
+        o.w = img.width;
+        o.h = img.height;
+        o.stride = (o.w + 63) >> 6;
+        o.bits.assign(o.stride * o.h, 0);
+        o.spans.assign(o.h, HullOutline::Span());
+        for (int y = 0; y < o.h; ++y)
+        {
+            HullOutline::Span& span = o.spans[y];
+            span.first = (s16)o.w;
+            for (int x = 0; x < o.w; ++x)
+            {
+                Color c = colors[x + y * o.w];
+                // Fully black pixels count as empty, same as transparent ones.
+                if (c.a == 0 || (c.r | c.g | c.b) == 0) continue;
+                o.bits[y * o.stride + (x >> 6)] |= 1ull << (x & 63);
+                if (span.first > x) span.first = (s16)x;
+                span.last = (s16)x;
+            }
+        }
+        UnloadImageColors(colors);
+        UnloadImage(img);
+    }
+    hull_outlines_loaded.store(true, std::memory_order_release);
+}
+
+void loadHullOutlinesAsync()
+{
+    if (hull_outlines_future.valid()) return;
+    hull_outlines_future = std::async(std::launch::async, decodeHullOutlines).share();
+}
+
+void loadHullOutlines()
+{
+    if (hull_outlines_loaded.load(std::memory_order_acquire)) return;
+    loadHullOutlinesAsync();
+    hull_outlines_future.wait();
+}
+
+const HullOutline& getHullOutline(int index)
+{
+    debug_assertf(hull_outlines_loaded, "Hull outlines must be loaded before generating ships");
+    return hull_outlines[index];
+}
+
 struct ShipGenerator
 {
     int w, h;
-    Image outline;
+    const HullOutline& outline;
 
     int size;
 
@@ -649,37 +744,38 @@ struct ShipGenerator
     std::vector<Room> decorate_rooms;
     std::vector<PlacedRoom> placed_rooms;
 
-    static Image getImage(const char* name)
-    {
-        static linear_map<sstring, Image> cache;
-        auto it = cache.find(name);
-        if (it.found) return it.value;
-        Image img = LoadImage(name);
-        cache.insert(name, img);
-        return img;
-    }
+    // Index into rooms for every pixel of the outline, -1 if no room covers it.
+    std::vector<int> room_grid;
 
-    ShipGenerator(const char* shape_name, int size)
-        : size(size)
+    ShipGenerator(const HullOutline& outline, int size)
+        : outline(outline), size(size)
     {
-        outline = getImage(shape_name);
-        w = outline.width;
-        h = outline.height;
+        w = outline.w;
+        h = outline.h;
     }
     ~ShipGenerator()
     {
     }
 
-    Room* getRoom(int x, int y)
+    void indexRooms()
     {
-        for (Room& r : rooms)
+        room_grid.assign(w * h, -1);
+        // Neighbouring rooms share a wall, walk backwards so the earlier room
+        // owns the shared tiles.
+        for (int i = (int)rooms.size() - 1; i >= 0; --i)
         {
-            if (x >= r.min.x && x <= r.max.x && y >= r.min.y && y <= r.max.y)
-            {
-                return &r;
-            }
+            Room& r = rooms[i];
+            for (int y = r.min.y; y <= r.max.y && y < h; ++y)
+                for (int x = r.min.x; x <= r.max.x && x < w; ++x)
+                    room_grid[x + y * w] = i;
         }
-        return nullptr;
+    }
+
+    Room* getRoom(int x, int y)
+    {
+        if (x < 0 || x >= w || y < 0 || y >= h) return nullptr;
+        int idx = room_grid[x + y * w];
+        return idx < 0 ? nullptr : &rooms[idx];
     }
 
     Room* getRoom(Room* from, Direction dir)
@@ -700,11 +796,9 @@ struct ShipGenerator
         return getRoom(from, vec2i(dx, dy));
     }
 
-    u32 get(int x, int y)
+    bool get(int x, int y)
     {
-        Color c = GetImageColor(outline, x, y);
-        if (c.a == 0) return 0;
-        return (u32(c.r) << 16) | (u32(c.g) << 8) | u32(c.b);
+        return outline.test(x, y);
     }
 
     bool check(float x, float y)
@@ -785,10 +879,8 @@ struct ShipGenerator
         return candidates[(size_t) scalar::floori(candidates.size() * rng.nextFloat())];
     }
 
-    bool generate(Ship* ship, Map& map, ShipParameters& params)
+    bool generate(Ship* ship, Map& map, ShipParameters& params, pcg32& rng)
     {
-        pcg32 rng;
-
         for (int y = 0; y + size + 1 < h; y += size + 1)
         {
             for (int x = 0; x + size + 1 < w; x += size + 1)
@@ -798,17 +890,9 @@ struct ShipGenerator
                 bool needs_decorating = false;
                 for (int y0 = y + 1; y0 <= y + size; ++y0)
                 {
-                    for (int x0 = x + 1; x0 <= x + size; ++x0)
-                    {
-                        if (get(x0, h - y0 - 1) == 0)
-                        {
-                            valid_room = false;
-                        }
-                        else
-                        {
-                            needs_decorating = true;
-                        }
-                    }
+                    int c = outline.count(h - y0 - 1, x + 1, x + size);
+                    if (c != size) valid_room = false;
+                    if (c != 0) needs_decorating = true;
                 }
 
                 if (valid_room)
@@ -821,6 +905,7 @@ struct ShipGenerator
                 }
             }
         }
+        indexRooms();
 
         std::deque<Room*> open;
         linear_map<vec2i, bool> seen;
@@ -862,6 +947,7 @@ struct ShipGenerator
         }
 
         // Rooms is frozen from ehre on!!!
+        indexRooms();
         for (Room& r : rooms)
         {
             for (int i = 0; i < 4; ++i)
@@ -874,16 +960,24 @@ struct ShipGenerator
         }
 
         // Engines
-        std::vector<int> back_distance;
-        for (int x = 0; x < w; ++x)
+        std::vector<int> back_distance(w, h);
         {
-            back_distance.push_back(h);
+            // Sweep rows from the back of the ship, a column's distance is the
+            // first row where its bit appears.
+            std::vector<u64> remaining(outline.stride, ~0ull);
             for (int y = 0; y < h; ++y)
             {
-                if (get(x, h - y - 1))
+                const u64* row = &outline.bits[(h - y - 1) * outline.stride];
+                for (int i = 0; i < outline.stride; ++i)
                 {
-                    back_distance.back() = y;
-                    break;
+                    u64 hit = row[i] & remaining[i];
+                    remaining[i] &= ~hit;
+                    while (hit)
+                    {
+                        int x = (i << 6) + std::countr_zero(hit);
+                        back_distance[x] = y;
+                        hit &= hit - 1;
+                    }
                 }
             }
         }
@@ -1289,102 +1383,92 @@ struct ShipGenerator
                 }
             }
         }
+        ship->indexRooms();
         return true;
     }
 };
 
-Ship* generate(const sstring& name, const char* type)
+Ship* generate(const sstring& name, const char* type, pcg32& rng, int outline, GenerateStats* stats)
 {
-    pcg32 rng;
-    static const char* ship_shapes[]
-    {
-        "assets/ship_0.png",
-        "assets/ship_1.png",
-        "assets/ship_2.png",
-        "assets/ship_3.png",
-        "assets/ship_4.png",
-        "assets/ship_5.png",
-        "assets/ship_6.png",
-    };
-
-    if (strings::equals(type, "player_ship"))
+    PROFILE_ZONE("generate");
+    loadHullOutlines();
+    ShipParameters params;
+    bool is_player = strings::equals(type, "player_ship");
+    if (is_player)
     {
-        Map* map = new Map(name);
-        Ship* ship = new Ship(map);
-
-        ShipGenerator shape(ship_shapes[rng.nextInt(0, 7)], 3);
-        ShipParameters params;
         params.primary_color = 0xFF14CCFF;
         params.secondary_color = 0xFFC0C0C0;
-
-        bool success = false;
-        for (int a = 0; a < 10; ++a)
-        {
-            if (shape.generate(ship, *map, params))
-            {
-                success = true;
-                break;
-            }
-        }
-        debug_assertf(success, "Failed to generate ship layout within 10 attempts");
-
-        ShipRoom* pilot = ship->getRoom(RoomType::PilotsDeck);
-
-        Player* player = new Player(pilot->min + vec2i(2, 2));
-        map->player = player;
-        map->spawn(player);
-        return ship;
     }
     else if (strings::equals(type, "cargo_ship"))
     {
-        Map* map = new Map(name);
-        Ship* ship = new Ship(map);
-
-        ShipGenerator shape(ship_shapes[rng.nextInt(0, 7)], 3);
-        ShipParameters params;
         params.primary_color = 0xFF14CCFF;
         params.secondary_color = 0xFFC0C0C0;
         params.max_pdcs = 6;
         params.max_railguns = 0;
         params.max_torpedos = 0;
-
-        bool success = false;
-        for (int a = 0; a < 10; ++a)
-        {
-            if (shape.generate(ship, *map, params))
-            {
-                success = true;
-                break;
-            }
-        }
-        debug_assertf(success, "Failed to generate ship layout within 10 attempts");
-        return ship;
     }
     else if (strings::equals(type, "pirate_ship"))
     {
-        Map* map = new Map(name);
-        Ship* ship = new Ship(map);
-
-        ShipGenerator shape(ship_shapes[rng.nextInt(0, 7)], 3);
-        ShipParameters params;
         params.primary_color = 0xFFFFCC14;
         params.secondary_color = 0xFFC0C0C0;
         params.max_pdcs = 2;
         params.max_railguns = 1;
         params.max_torpedos = 4;
+    }
+    else
+    {
+        debug_assertf(false, "Unknown ship layout type");
+        return nullptr;
+    }
+
+    if (outline < 0) outline = rng.nextInt(0, HullOutlineCount);
+
+    Map* map = new Map(name);
+    Ship* ship = new Ship(map);
+
+    ShipGenerator shape(getHullOutline(outline), 3);
 
-        bool success = false;
-        for (int a = 0; a < 10; ++a)
+    int attempts = 0;
+    bool success = false;
+    while (attempts < 10)
+    {
+        ++attempts;
+        if (shape.generate(ship, *map, params, rng))
         {
-            if (shape.generate(ship, *map, params))
-            {
-                success = true;
-                break;
-            }
+            success = true;
+            break;
         }
-        debug_assertf(success, "Failed to generate ship layout within 10 attempts");
-        return ship;
     }
-    debug_assertf(false, "Unknown ship layout type");
-    return nullptr;
+    if (stats)
+    {
+        stats->outline = outline;
+        stats->attempts = attempts;
+        stats->success = success;
+    }
+    debug_assertf(success, "Failed to generate ship layout within 10 attempts");
+
+    if (is_player)
+    {
+        ShipRoom* pilot = ship->getRoom(RoomType::PilotsDeck);
+
+        Player* player = new Player(pilot->min + vec2i(2, 2));
+        map->player = player;
+        map->spawn(player);
+    }
+    return ship;
+}
+
+std::vector<Ship*> generateBatch(const GenerateRequest* requests, const u64* seeds, int count)
+{
+    PROFILE_ZONE("generateBatch");
+    // Workers never wait on the outlines, the batch does it up front.
+    loadHullOutlines();
+    std::vector<Ship*> ships(count, nullptr);
+    // Every ship has its own seed, so the result does not depend on which thread built it.
+    parallel_for(0, count, 1, [&](int i)
+    {
+        pcg32 rng(seeds[i]);
+        ships[i] = generate(requests[i].name, requests[i].type, rng, requests[i].outline);
+    });
+    return ships;
 }
@@ -1,7 +1,64 @@
 #pragma once
 
+#include <vector>
+
 #include "util/string.h"
 
 struct Ship;
+struct pcg32;
+
+// Occupancy mask of a hull outline image, one bit per pixel packed into
+// 64-bit words per row. Rows are stored in image order (top row first).
+struct HullOutline
+{
+    struct Span
+    {
+        s16 first = 0;
+        s16 last = -1;
+    };
+
+    int w = 0, h = 0;
+    int stride = 0;
+    std::vector<u64> bits;
+    // First and last occupied column of each row, first > last for an empty row.
+    std::vector<Span> spans;
+
+    bool test(int x, int y) const
+    {
+        if (x < 0 || x >= w || y < 0 || y >= h) return false;
+        return (bits[y * stride + (x >> 6)] >> (x & 63)) & 1;
+    }
+
+    // Number of occupied pixels in row y between x0 and x1 inclusive.
+    int count(int y, int x0, int x1) const;
+};
+
+constexpr int HullOutlineCount = 7;
+
+// Starts decoding the outlines on a background thread.
+void loadHullOutlinesAsync();
+// Waits for the outlines, starting the decode if it has not been started.
+void loadHullOutlines();
+const HullOutline& getHullOutline(int index);
+
+struct GenerateStats
+{
+    int outline = -1;
+    int attempts = 0;
+    bool success = false;
+};
+
+// Generates a ship layout of the given type using rng. A negative outline picks one at random.
+Ship* generate(const sstring& name, const char* type, pcg32& rng, int outline = -1, GenerateStats* stats = nullptr);
+
+struct GenerateRequest
+{
+    sstring name;
+    const char* type;
+    int outline = -1;
+};
 
-Ship* generate(const sstring& name, const char* type);
+// Generates requests[i] seeded with seeds[i] on a pool of worker threads. Workers only
+// read the registry and hull outlines, so the returned ships (in request order) are
+// owned by the caller and nothing else needs adopting.
+std::vector<Ship*> generateBatch(const GenerateRequest* requests, const u64* seeds, int count);
@@ -0,0 +1,281 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+#include "util/string.h"
+
+#include "vterm.h"
+
+Profiler g_profiler;
+
+constexpr u32 ProfileRingSize = 4096;
+constexpr int ProfileMaxDepth = 64;
+
+// Events are written by the owning thread only and drained by profilerFrame on the main thread.
+struct ProfileThread
+{
+    u32 id;
+    // Track name in the trace, set by the owning thread through profileThreadName.
+    char name[32] = "";
+    ProfileEvent events[ProfileRingSize];
+    std::atomic<u32> head = 0;
+    u32 read = 0;
+
+    const char* stack[ProfileMaxDepth];
+    int depth = 0;
+
+    // Set once the owning thread exits, the buffer is reused after it has been drained.
+    std::atomic<bool> retired = false;
+    bool free = false;
+};
+
+std::mutex profile_threads_mutex;
+std::vector<ProfileThread*> profile_threads;
+std::vector<ProfileThread*> profile_free_threads;
+
+struct ProfileThreadHandle
+{
+    ProfileThread* thread = nullptr;
+
+    ~ProfileThreadHandle()
+    {
+        if (thread) thread->retired.store(true, std::memory_order_release);
+    }
+};
+thread_local ProfileThreadHandle profile_thread;
+
+ProfileThread* getProfileThread()
+{
+    if (!profile_thread.thread)
+    {
+        std::lock_guard<std::mutex> lock(profile_threads_mutex);
+        ProfileThread* t;
+        if (!profile_free_threads.empty())
+        {
+            t = profile_free_threads.back();
+            profile_free_threads.pop_back();
+            t->free = false;
+            t->depth = 0;
+            t->name[0] = 0;
+            t->retired.store(false, std::memory_order_relaxed);
+        }
+        else
+        {
+            t = new ProfileThread;
+            t->id = (u32)profile_threads.size();
+            profile_threads.push_back(t);
+        }
+        profile_thread.thread = t;
+    }
+    return profile_thread.thread;
+}
+
+void profileThreadName(const char* name)
+{
+    ProfileThread* t = getProfileThread();
+    std::lock_guard<std::mutex> lock(profile_threads_mutex);
+    snprintf(t->name, sizeof(t->name), "%s", name);
+}
+
+u64 profileNow()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ProfileScope::ProfileScope(const char* name)
+    : name(name), open(true)
+{
+    ProfileThread* t = getProfileThread();
+    if (t->depth < ProfileMaxDepth) t->stack[t->depth] = name;
+    t->depth++;
+    start = profileNow();
+}
+
+void ProfileScope::end()
+{
+    if (!open) return;
+    open = false;
+    u64 now = profileNow();
+
+    ProfileThread* t = profile_thread.thread;
+    t->depth--;
+    u32 head = t->head.load(std::memory_order_relaxed);
+    ProfileEvent& e = t->events[head % ProfileRingSize];
+    e.name = name;
+    e.parent = t->depth > 0 ? t->stack[std::min(t->depth, ProfileMaxDepth) - 1] : nullptr;
+    e.start = start;
+    e.end = now;
+    e.depth = (u16)t->depth;
+    e.counter = false;
+    e.value = 0;
+    t->head.store(head + 1, std::memory_order_release);
+}
+
+void profileCounter(const char* name, s64 value)
+{
+    ProfileThread* t = getProfileThread();
+    u64 now = profileNow();
+    u32 head = t->head.load(std::memory_order_relaxed);
+    ProfileEvent& e = t->events[head % ProfileRingSize];
+    e.name = name;
+    e.parent = nullptr;
+    e.start = now;
+    e.end = now;
+    e.depth = 0;
+    e.counter = true;
+    e.value = value;
+    t->head.store(head + 1, std::memory_order_release);
+}
+
+void addZoneSample(const ProfileEvent& e)
+{
+    ProfileZoneStats* zone = nullptr;
+    for (ProfileZoneStats& z : g_profiler.zones)
+    {
+        if (z.name == e.name && z.parent == e.parent)
+        {
+            zone = &z;
+            break;
+        }
+    }
+    if (!zone)
+    {
+        zone = &g_profiler.zones.emplace_back();
+        zone->name = e.name;
+        zone->parent = e.parent;
+        zone->depth = e.depth;
+    }
+    zone->samples[zone->sample_head] = e.end - e.start;
+    zone->sample_head = (zone->sample_head + 1) % ProfileZoneStats::Samples;
+    if (zone->sample_count < ProfileZoneStats::Samples) zone->sample_count++;
+}
+
+void addTraceEvent(const ProfileEvent& e, u32 thread)
+{
+    Profiler& p = g_profiler;
+    if (p.trace.empty())
+        p.trace.resize(Profiler::TraceCapacity);
+    p.trace[p.trace_head] = TraceEvent{ e, thread };
+    p.trace_head = (p.trace_head + 1) % Profiler::TraceCapacity;
+    if (p.trace_count < Profiler::TraceCapacity) p.trace_count++;
+}
+
+void profilerFrame()
+{
+    std::lock_guard<std::mutex> lock(profile_threads_mutex);
+    for (ProfileThread* t : profile_threads)
+    {
+        if (t->free) continue;
+        bool retired = t->retired.load(std::memory_order_acquire);
+        u32 head = t->head.load(std::memory_order_acquire);
+        // If the thread lapped the ring since the last frame only the newest events survive.
+        u32 from = head - t->read > ProfileRingSize ? head - ProfileRingSize : t->read;
+        for (u32 i = from; i != head; ++i)
+        {
+            const ProfileEvent& e = t->events[i % ProfileRingSize];
+            if (!e.counter) addZoneSample(e);
+            addTraceEvent(e, t->id);
+        }
+        t->read = head;
+
+        if (retired)
+        {
+            t->free = true;
+            profile_free_threads.push_back(t);
+        }
+    }
+}
+
+void drawZones(TextBuffer& buf, const char* parent, int depth, int& y)
+{
+    static std::vector<u64> sorted;
+    if (depth > 16) return;
+    for (ProfileZoneStats& z : g_profiler.zones)
+    {
+        if (z.parent != parent || z.sample_count == 0) continue;
+
+        sorted.assign(z.samples, z.samples + z.sample_count);
+        std::sort(sorted.begin(), sorted.end());
+        u64 sum = 0;
+        for (u64 s : sorted) sum += s;
+        double min = sorted.front() / 1e6;
+        double avg = sum / 1e6 / sorted.size();
+        double p99 = sorted[std::min(sorted.size() - 1, sorted.size() * 99 / 100)] / 1e6;
+
+        sstring line;
+        line.appendf("%*s%-*s %8.3f %8.3f %8.3f", depth * 2, "", 32 - depth * 2, z.name, min, avg, p99);
+        buf.write(vec2i(2, y++), line.c_str(), 0xFFFFFFFF, LayerPriority_Debug);
+
+        drawZones(buf, z.name, depth + 1, y);
+    }
+}
+
+void drawProfiler(TextBuffer& buf)
+{
+    if (!g_profiler.overlay) return;
+    buf.fillBg(vec2i(0, 0), vec2i(32, (int)g_profiler.zones.size() + 2), 0xE0101010, LayerPriority_Debug);
+    sstring header;
+    header.appendf("%-32s %8s %8s %8s", "Zone (ms, F3 to hide)", "min", "avg", "p99");
+    buf.write(vec2i(2, 1), header.c_str(), 0xFFFFFF00, LayerPriority_Debug);
+    int y = 2;
+    drawZones(buf, nullptr, 0, y);
+}
+
+void writeJsonString(FILE* f, const char* s)
+{
+    fputc('"', f);
+    for (; *s; ++s)
+    {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+bool writeChromeTrace(const char* path)
+{
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+
+    Profiler& p = g_profiler;
+    int first = (p.trace_head - p.trace_count + Profiler::TraceCapacity) % Profiler::TraceCapacity;
+    u64 origin = ~0ull;
+    for (int i = 0; i < p.trace_count; ++i)
+        origin = std::min(origin, p.trace[(first + i) % Profiler::TraceCapacity].event.start);
+    u32 max_thread = 0;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    for (int i = 0; i < p.trace_count; ++i)
+    {
+        const TraceEvent& t = p.trace[(first + i) % Profiler::TraceCapacity];
+        const ProfileEvent& e = t.event;
+        if (t.thread > max_thread) max_thread = t.thread;
+        // Zones are recorded as they close so events are not sorted, the viewers do not need them to be.
+        double ts = (e.start - origin) / 1000.0;
+        fprintf(f, "{\"name\":");
+        writeJsonString(f, e.name);
+        if (e.counter)
+            fprintf(f, ",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%lld}},\n", ts, t.thread, (long long)e.value);
+        else
+            fprintf(f, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u},\n", ts, (e.end - e.start) / 1000.0, t.thread);
+    }
+    {
+        std::lock_guard<std::mutex> lock(profile_threads_mutex);
+        for (ProfileThread* t : profile_threads)
+        {
+            if (t->id > max_thread) continue;
+            char unnamed[32];
+            snprintf(unnamed, sizeof(unnamed), "thread %u", t->id);
+            fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", t->id);
+            writeJsonString(f, t->name[0] ? t->name : unnamed);
+            fprintf(f, "}},\n");
+        }
+    }
+    fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"7drl\"}}\n]}\n");
+    fclose(f);
+    return true;
+}
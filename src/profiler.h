@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+
+struct TextBuffer;
+
+// Scoped timing zones. PROFILE_ZONE("name") times the rest of the enclosing scope on
+// the calling thread. Names must be string literals, zones are keyed by pointer.
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileScope PROFILE_CONCAT(profile_zone_, __LINE__)(name)
+
+struct ProfileEvent
+{
+    const char* name;
+    const char* parent;
+    u64 start, end;
+    u16 depth;
+    // Counter samples have start == end and carry value instead of a duration.
+    bool counter;
+    s64 value;
+};
+
+// Times from construction until end() or destruction, whichever comes first.
+struct ProfileScope
+{
+    const char* name;
+    u64 start;
+    bool open;
+
+    ProfileScope(const char* name);
+    ~ProfileScope() { end(); }
+
+    void end();
+};
+
+struct ProfileZoneStats
+{
+    static constexpr int Samples = 256;
+
+    const char* name;
+    const char* parent;
+    u16 depth;
+
+    // Rolling window of the last Samples durations, in nanoseconds.
+    u64 samples[Samples];
+    int sample_count = 0;
+    int sample_head = 0;
+};
+
+struct TraceEvent
+{
+    ProfileEvent event;
+    u32 thread;
+};
+
+struct Profiler
+{
+    bool overlay = false;
+    std::vector<ProfileZoneStats> zones;
+
+    // Bounded history of every drained event for trace export, oldest overwritten first.
+    static constexpr int TraceCapacity = 1 << 17;
+    std::vector<TraceEvent> trace;
+    int trace_head = 0;
+    int trace_count = 0;
+};
+extern Profiler g_profiler;
+
+u64 profileNow();
+
+// Names the calling thread's track in the trace, e.g. "main", "sim" or "job 3".
+void profileThreadName(const char* name);
+
+// Records a sample on a named counter track, names must be string literals.
+void profileCounter(const char* name, s64 value);
+
+// Drains every thread's event ring into the rolling zone stats and trace history. Call once per frame.
+void profilerFrame();
+void drawProfiler(TextBuffer& buf);
+
+// Writes the trace history as Chrome trace event JSON, loadable in chrome://tracing or Perfetto.
+bool writeChromeTrace(const char* path);
@@ -0,0 +1,395 @@
+#include "replay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "util/arena.h"
+
+#include "game.h"
+#include "map.h"
+#include "procgen.h"
+#include "profiler.h"
+#include "save.h"
+#include "sound.h"
+#include "universe.h"
+
+InputSystem g_input;
+
+// raylib tracks this many key codes and mouse buttons.
+constexpr int InputMaxKeys = 512;
+constexpr int InputMouseButtons = 7;
+
+// Stored in the log header so a replay sees the same keys as the recording.
+int* const replay_key_bindings[] = {
+    &g_game.key_left, &g_game.key_right, &g_game.key_up, &g_game.key_down,
+    &g_game.key_fire, &g_game.key_railgun, &g_game.key_dock, &g_game.key_open,
+    &g_game.key_use, &g_game.key_pickup, &g_game.key_wait, &g_game.key_hail,
+};
+constexpr int ReplayKeyBindingCount = sizeof(replay_key_bindings) / sizeof(replay_key_bindings[0]);
+
+// Replays and the sim thread answer every query from g_input.frame.
+bool inputFromFrame()
+{
+    return g_input.mode == InputMode::Replay || g_input.queued;
+}
+
+bool inputKeyPressed(int key)
+{
+    if (!inputFromFrame()) return IsKeyPressed(key);
+    for (u16 k : g_input.frame.keys)
+    {
+        if (k == key) return true;
+    }
+    return false;
+}
+
+bool inputMousePressed(int button)
+{
+    if (!inputFromFrame()) return IsMouseButtonPressed(button);
+    return button >= 0 && button < InputMouseButtons && (g_input.frame.mouse_buttons & (1 << button));
+}
+
+int inputMouseX()
+{
+    return !inputFromFrame() ? GetMouseX() : g_input.frame.mouse_x;
+}
+
+int inputMouseY()
+{
+    return !inputFromFrame() ? GetMouseY() : g_input.frame.mouse_y;
+}
+
+float inputMouseWheel()
+{
+    return !inputFromFrame() ? GetMouseWheelMove() : (float)g_input.frame.wheel;
+}
+
+int inputGetKeyPressed()
+{
+    if (!inputFromFrame()) return GetKeyPressed();
+    return g_input.frame.keys.empty() ? 0 : g_input.frame.keys[0];
+}
+
+void InputFrame::clearPresses()
+{
+    keys.clear();
+    mouse_buttons = 0;
+    wheel = 0;
+}
+
+void InputFrame::merge(const InputFrame& f)
+{
+    for (u16 k : f.keys)
+    {
+        bool found = false;
+        for (u16 existing : keys) found |= existing == k;
+        if (!found) keys.push_back(k);
+    }
+    mouse_buttons |= f.mouse_buttons;
+    if (f.wheel != 0) wheel = f.wheel;
+    mouse_x = f.mouse_x;
+    mouse_y = f.mouse_y;
+    w = f.w;
+    h = f.h;
+}
+
+void captureInputFrame(InputFrame& f)
+{
+    f.clearPresses();
+    for (int k = 1; k < InputMaxKeys; ++k)
+    {
+        if (IsKeyPressed(k)) f.keys.push_back((u16)k);
+    }
+    for (int b = 0; b < InputMouseButtons; ++b)
+    {
+        if (IsMouseButtonPressed(b)) f.mouse_buttons |= 1 << b;
+    }
+    // The game only checks whether the wheel moved.
+    float wheel = GetMouseWheelMove();
+    f.wheel = wheel > 0 ? 1 : wheel < 0 ? -1 : 0;
+    f.mouse_x = (s16)GetMouseX();
+    f.mouse_y = (s16)GetMouseY();
+}
+
+bool InputQueue::push(const InputFrame& f)
+{
+    u32 t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == Capacity) return false;
+    // Assigning keeps the slot's key storage, the queue stops allocating once warm.
+    InputFrame& slot = frames[t % Capacity];
+    slot.keys.assign(f.keys.begin(), f.keys.end());
+    slot.mouse_buttons = f.mouse_buttons;
+    slot.wheel = f.wheel;
+    slot.mouse_x = f.mouse_x;
+    slot.mouse_y = f.mouse_y;
+    slot.w = f.w;
+    slot.h = f.h;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool InputQueue::pop(InputFrame& f)
+{
+    u32 h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    f.merge(frames[h % Capacity]);
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+void writeValue(std::vector<u8>& log, T v)
+{
+    const u8* b = (const u8*)&v;
+    log.insert(log.end(), b, b + sizeof(T));
+}
+
+void writeVarint(std::vector<u8>& log, u64 v)
+{
+    while (v >= 0x80)
+    {
+        log.push_back((u8)(v | 0x80));
+        v >>= 7;
+    }
+    log.push_back((u8)v);
+}
+
+// Records store their frame as a delta from the previous record.
+void writeRecord(ReplayRecord type)
+{
+    writeValue(g_input.log, (u8)type);
+    writeVarint(g_input.log, g_game.frame - g_input.last_record_frame);
+    g_input.last_record_frame = g_game.frame;
+}
+
+void beginInputFrame()
+{
+    if (g_input.mode != InputMode::Record) return;
+
+    // On the sim thread the frame was already filled from the input queue.
+    InputFrame& f = g_input.frame;
+    if (!g_input.queued) captureInputFrame(f);
+    if (f.empty()) return;
+
+    f.w = (u8)g_game.w;
+    f.h = (u8)g_game.h;
+
+    std::vector<u8>& log = g_input.log;
+    writeRecord(ReplayRecord::Input);
+    u8 key_count = (u8)scalar::min((int)f.keys.size(), 255);
+    writeValue(log, key_count);
+    for (int i = 0; i < key_count; ++i) writeValue(log, f.keys[i]);
+    writeValue(log, f.mouse_buttons);
+    writeValue(log, f.wheel);
+    writeValue(log, f.mouse_x);
+    writeValue(log, f.mouse_y);
+    writeValue(log, f.w);
+    writeValue(log, f.h);
+}
+
+void endInputFrame()
+{
+    if (g_input.mode != InputMode::Record || !g_game.current_level) return;
+
+    int turn = g_game.current_level->turn;
+    if (turn == g_input.last_checkpoint_turn || turn % ReplayCheckpointTurns != 0) return;
+    g_input.last_checkpoint_turn = turn;
+
+    writeRecord(ReplayRecord::Checkpoint);
+    writeValue(g_input.log, (s32)turn);
+    writeValue(g_input.log, hashGameState());
+}
+
+void startRecording(const char* path)
+{
+    stopRecording();
+
+    g_input.mode = InputMode::Record;
+    g_input.record_path = path;
+    g_input.log.clear();
+    g_input.last_record_frame = g_game.frame;
+    g_input.last_checkpoint_turn = 0;
+
+    std::vector<u8>& log = g_input.log;
+    writeValue(log, ReplayMagic);
+    writeValue(log, ReplayVersion);
+    writeValue(log, g_game.seed);
+    writeValue(log, (u8)ReplayKeyBindingCount);
+    for (int* key : replay_key_bindings) writeValue(log, (s32)*key);
+}
+
+void stopRecording()
+{
+    if (g_input.mode != InputMode::Record) return;
+    g_input.mode = InputMode::Live;
+
+    writeRecord(ReplayRecord::End);
+    FILE* f = fopen(g_input.record_path.c_str(), "wb");
+    if (!f) return;
+    fwrite(g_input.log.data(), 1, g_input.log.size(), f);
+    fclose(f);
+}
+
+struct ReplayReader
+{
+    std::vector<u8> data;
+    size_t cursor = 0;
+    bool failed = false;
+
+    bool load(const char* path)
+    {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        fseek(f, 0, SEEK_END);
+        long size = ftell(f);
+        fseek(f, 0, SEEK_SET);
+        data.resize(size > 0 ? (size_t)size : 0);
+        bool ok = fread(data.data(), 1, data.size(), f) == data.size();
+        fclose(f);
+        return ok;
+    }
+
+    template<typename T>
+    T value()
+    {
+        T v{};
+        if (failed || sizeof(T) > data.size() - cursor)
+        {
+            failed = true;
+            return v;
+        }
+        memcpy(&v, data.data() + cursor, sizeof(T));
+        cursor += sizeof(T);
+        return v;
+    }
+
+    u64 varint()
+    {
+        u64 v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            u8 b = value<u8>();
+            v |= (u64)(b & 0x7F) << shift;
+            if (!(b & 0x80)) break;
+        }
+        return v;
+    }
+};
+
+void stepReplayFrame()
+{
+    // Recordings only contain frames the game was running in, skipping any time spent paused.
+    g_game.state = GameState::Ingame;
+    updateGame();
+    updateSounds();
+    frameArena().reset();
+    profilerFrame();
+}
+
+int runReplay(const char* path)
+{
+    ReplayReader r;
+    if (!r.load(path))
+    {
+        printf("Could not read %s\n", path);
+        return 1;
+    }
+    u32 magic = r.value<u32>();
+    u32 version = r.value<u32>();
+    if (magic != ReplayMagic || version != ReplayVersion)
+    {
+        printf("%s is not a version %u replay\n", path, ReplayVersion);
+        return 1;
+    }
+    u64 seed = r.value<u64>();
+    int key_count = r.value<u8>();
+    for (int i = 0; i < key_count; ++i)
+    {
+        s32 key = r.value<s32>();
+        if (i < ReplayKeyBindingCount) *replay_key_bindings[i] = key;
+    }
+
+    loadHullOutlines();
+    g_input.mode = InputMode::Replay;
+    g_game.state = GameState::Ingame;
+    startGame(seed);
+
+    int checkpoints = 0, mismatches = 0;
+    u64 frame = 0;
+    bool done = false;
+    auto start = std::chrono::steady_clock::now();
+    while (!done && !r.failed)
+    {
+        ReplayRecord type = (ReplayRecord)r.value<u8>();
+        frame += r.varint();
+        if (r.failed) break;
+
+        // Frames without input still run, animations and transitions advance on them.
+        g_input.frame = InputFrame();
+        while (g_game.frame + 1 < frame) stepReplayFrame();
+
+        switch (type)
+        {
+        case ReplayRecord::Input:
+        {
+            InputFrame& f = g_input.frame;
+            int count = r.value<u8>();
+            for (int i = 0; i < count; ++i) f.keys.push_back(r.value<u16>());
+            f.mouse_buttons = r.value<u8>();
+            f.wheel = r.value<s8>();
+            f.mouse_x = r.value<s16>();
+            f.mouse_y = r.value<s16>();
+            f.w = r.value<u8>();
+            f.h = r.value<u8>();
+            g_game.w = f.w;
+            g_game.h = f.h;
+            stepReplayFrame();
+        } break;
+        case ReplayRecord::Checkpoint:
+        {
+            s32 turn = r.value<s32>();
+            u64 expected = r.value<u64>();
+            if (r.failed) break;
+            // A checkpoint follows the input record of the same frame, if there was one.
+            if (g_game.frame < frame) stepReplayFrame();
+            checkpoints++;
+            u64 actual = hashGameState();
+            if (actual != expected)
+            {
+                mismatches++;
+                printf("Checkpoint mismatch at frame %llu, turn %d: expected %016llx, got %016llx\n",
+                    (unsigned long long)frame, turn, (unsigned long long)expected, (unsigned long long)actual);
+            }
+        } break;
+        case ReplayRecord::End:
+        {
+            if (g_game.frame < frame) stepReplayFrame();
+            done = true;
+        } break;
+        default:
+        {
+            r.failed = true;
+        } break;
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    if (r.failed) printf("%s is truncated or corrupt\n", path);
+    printf("%llu frames, %d turns, %d universe ticks in %.1f ms (%.0f frames/sec)\n",
+        (unsigned long long)g_game.frame, g_game.current_level->turn, g_game.universe->universe_ticks,
+        ms, g_game.frame * 1000.0 / scalar::max(ms, 1e-3));
+    printf("%d checkpoints, %d mismatched, final state %016llx\n", checkpoints, mismatches, (unsigned long long)hashGameState());
+    u64 requested = 0, played = 0;
+    for (int i = 0; i < SoundEffectCount; ++i)
+    {
+        requested += soundStats().requested[i];
+        played += soundStats().played[i];
+    }
+    printf("%llu sounds requested, %llu played\n", (unsigned long long)requested, (unsigned long long)played);
+    printf("Frame arena peak %llu bytes, %llu heap fallbacks\n", (unsigned long long)frameArena().peak, (unsigned long long)frameArena().overflow_count);
+
+    g_input.mode = InputMode::Live;
+    return r.failed || mismatches ? 1 : 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "util/string.h"
+
+// Input seen by one game frame. Live and recording runs query raylib directly, a replay
+// answers every query from the recorded frame instead.
+struct InputFrame
+{
+    std::vector<u16> keys;
+    u8 mouse_buttons = 0;
+    s8 wheel = 0;
+    s16 mouse_x = 0, mouse_y = 0;
+    // Screen size in tiles, the mouse is mapped to tiles through it.
+    u8 w = 0, h = 0;
+
+    bool empty() const { return keys.empty() && mouse_buttons == 0 && wheel == 0; }
+
+    // Drops the presses but keeps the mouse position and screen size.
+    void clearPresses();
+    // Folds a later frame into this one, so no press is lost when several frames share a tick.
+    void merge(const InputFrame& f);
+};
+
+// Captures raylib's input for the current frame. w and h are left for the caller.
+void captureInputFrame(InputFrame& f);
+
+// Single producer, single consumer ring of frames, lock free. The render thread pushes
+// the input it polled each frame and the sim thread pops it at the start of each tick.
+struct InputQueue
+{
+    static constexpr int Capacity = 64;
+    InputFrame frames[Capacity];
+    std::atomic<u32> head = 0, tail = 0;
+
+    // Returns false without copying f when the queue is full.
+    bool push(const InputFrame& f);
+    // Merges the oldest frame into f.
+    bool pop(InputFrame& f);
+};
+
+enum class InputMode
+{
+    Live,
+    Record,
+    Replay,
+};
+
+// A replay log is a header followed by records in frame order. Frames without input are
+// not stored, and a state hash is stored every ReplayCheckpointTurns map turns.
+constexpr u32 ReplayMagic = 0x43455253; // "SREC"
+constexpr u32 ReplayVersion = 1;
+constexpr int ReplayCheckpointTurns = 10;
+
+enum class ReplayRecord : u8
+{
+    Input,
+    Checkpoint,
+    End,
+};
+
+struct InputSystem
+{
+    InputMode mode = InputMode::Live;
+    InputFrame frame;
+    // Set while the game runs on the sim thread, live queries then answer from frame too.
+    bool queued = false;
+    InputQueue queue;
+
+    sstring record_path;
+    std::vector<u8> log;
+    u64 last_record_frame = 0;
+    int last_checkpoint_turn = 0;
+};
+extern InputSystem g_input;
+
+bool inputKeyPressed(int key);
+bool inputMousePressed(int button);
+int inputMouseX();
+int inputMouseY();
+float inputMouseWheel();
+// The first key pressed this frame, or 0.
+int inputGetKeyPressed();
+
+// Called by updateGame around every game frame.
+void beginInputFrame();
+void endInputFrame();
+
+// Records the game that was just started until stopRecording(), which writes the log to path.
+void startRecording(const char* path);
+void stopRecording();
+
+// Replays a log headlessly, checking every checkpoint hash. Returns non-zero on a mismatch.
+int runReplay(const char* path);
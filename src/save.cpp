@@ -0,0 +1,784 @@
+#include "save.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "actor.h"
+#include "game.h"
+#include "map.h"
+#include "profiler.h"
+#include "ship.h"
+#include "universe.h"
+
+// Reads or writes fields in order, so saving and loading share one description of each type.
+// Reads past the end set failed and return zeroes, callers check failed once at the end.
+struct SaveArchive
+{
+    bool loading;
+    bool failed = false;
+    std::vector<u8> data;
+    size_t cursor = 0;
+
+    SaveArchive(bool loading) : loading(loading) {}
+
+    bool canRead(size_t n) const { return !failed && n <= data.size() - cursor; }
+
+    void bytes(void* p, size_t n)
+    {
+        if (loading)
+        {
+            if (!canRead(n))
+            {
+                failed = true;
+                memset(p, 0, n);
+                return;
+            }
+            memcpy(p, data.data() + cursor, n);
+            cursor += n;
+        }
+        else
+        {
+            const u8* b = (const u8*)p;
+            data.insert(data.end(), b, b + n);
+        }
+    }
+
+    template<typename T>
+    void value(T& v)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        bytes(&v, sizeof(T));
+    }
+
+    // Element counts are checked against the remaining data so a corrupt file cannot cause huge allocations.
+    u32 count(u32 n, size_t min_element_size)
+    {
+        value(n);
+        if (loading && !canRead(n * min_element_size))
+        {
+            failed = true;
+            return 0;
+        }
+        return n;
+    }
+
+    template<typename T>
+    void array(std::vector<T>& v, const T& fill)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        u32 n = count((u32)v.size(), sizeof(T));
+        if (loading) v.assign(n, fill);
+        if (n) bytes(v.data(), n * sizeof(T));
+    }
+
+    void string(sstring& s)
+    {
+        u32 n = count(s.size(), 1);
+        if (loading)
+        {
+            s = n ? sstring((const char*)data.data() + cursor, n) : sstring();
+            cursor += n;
+        }
+        else
+        {
+            bytes((void*)s.c_str(), n);
+        }
+    }
+
+    // Stored as text, ids differ between runs.
+    void string(istring& s)
+    {
+        if (loading)
+        {
+            sstring text;
+            string(text);
+            s = istring(text);
+        }
+        else
+        {
+            u32 n = count(s.size(), 1);
+            bytes((void*)s.c_str(), n);
+        }
+    }
+};
+
+// Tables are refilled in saved iteration order at their saved size, which keeps that order when
+// nothing was erased from them and avoids rehashing as they grow.
+template<typename K, typename E>
+void reserveTable(linear_map<K, E>& map, u32 capacity, u32 count)
+{
+    // The count was checked against the file size, the capacity was not.
+    map.reserve(scalar::min(capacity, count * 4 + 64));
+}
+
+struct SaveTile
+{
+    vec2i pos;
+    u8 terrain;
+    bool explored;
+    // Explicit so the padding is written as zeroes.
+    u16 unused = 0;
+};
+
+struct SaveCell
+{
+    vec2i pos;
+    u32 id;
+};
+
+struct SaveMover
+{
+    u32 id;
+    u32 flags;
+    vec2i track_pos;
+    vec2i track_vel;
+};
+
+struct SaveGameFields
+{
+    int credits;
+    int scrap;
+    pcg32 rng;
+    bool show_universe;
+    int last_universe_update;
+};
+
+void serializeItem(SaveArchive& ar, Item*& item)
+{
+    bool present = item != nullptr;
+    ar.value(present);
+    if (!present)
+    {
+        item = nullptr;
+        return;
+    }
+    if (ar.loading) item = new Item(0, 0, ItemType::Generic, "");
+    ar.value(item->character);
+    ar.value(item->color);
+    ar.value(item->type);
+    ar.string(item->name);
+    ar.value(item->count);
+    if ((u32)item->type >= (u32)ItemType::__COUNT) ar.failed = true;
+}
+
+Actor* createActor(ActorType type)
+{
+    switch (type)
+    {
+    case ActorType::GroundItem: return new GroundItem(vec2i(), nullptr);
+    case ActorType::Player: return new Player(vec2i());
+    case ActorType::Decoration: return new Decoration(vec2i(), 0, 0, 0, 0, 0);
+    case ActorType::InteriorDoor: return new InteriorDoor(vec2i());
+    case ActorType::Airlock: return new Airlock(vec2i(), Up);
+    case ActorType::PilotSeat: return new PilotSeat(vec2i());
+    case ActorType::Engine: return new MainEngine(vec2i());
+    case ActorType::Reactor: return new Reactor(vec2i());
+    case ActorType::Scanner: return new Scanner(vec2i());
+    case ActorType::TorpedoLauncher: return new TorpedoLauncher(vec2i());
+    case ActorType::PDC: return new PDC(vec2i());
+    case ActorType::Railgun: return new Railgun(vec2i());
+    default: return nullptr;
+    }
+}
+
+void serializeShipObject(SaveArchive& ar, ShipObject* o)
+{
+    ar.value(o->status);
+    ar.value(o->power_required);
+}
+
+void serializeActor(SaveArchive& ar, Actor* a)
+{
+    ar.value(a->pos);
+    ar.value(a->stored_energy);
+    ar.value(a->dead);
+    switch (a->type)
+    {
+    case ActorType::GroundItem:
+    {
+        serializeItem(ar, ((GroundItem*)a)->item);
+    } break;
+    case ActorType::Player:
+    {
+        Player* p = (Player*)a;
+        ar.value(p->health);
+        ar.value(p->max_health);
+        ar.value(p->is_aiming);
+        serializeItem(ar, p->holding);
+    } break;
+    case ActorType::Decoration:
+    {
+        Decoration* d = (Decoration*)a;
+        ar.value(d->left);
+        ar.value(d->right);
+        ar.value(d->leftcolor);
+        ar.value(d->rightcolor);
+        ar.value(d->bg);
+    } break;
+    case ActorType::InteriorDoor:
+    {
+        InteriorDoor* d = (InteriorDoor*)a;
+        ar.value(d->open);
+        ar.value(d->welded);
+    } break;
+    case ActorType::Airlock:
+    {
+        Airlock* d = (Airlock*)a;
+        ar.value(d->interior);
+        ar.value(d->open);
+        ar.value(d->welded);
+    } break;
+    case ActorType::PilotSeat:
+    case ActorType::Engine:
+    {
+        serializeShipObject(ar, (ShipObject*)a);
+    } break;
+    case ActorType::Scanner:
+    {
+        serializeShipObject(ar, (ShipObject*)a);
+        ar.value(((Scanner*)a)->range);
+    } break;
+    case ActorType::Reactor:
+    {
+        Reactor* r = (Reactor*)a;
+        serializeShipObject(ar, r);
+        ar.value(r->power);
+        ar.value(r->capacity);
+    } break;
+    case ActorType::TorpedoLauncher:
+    {
+        TorpedoLauncher* t = (TorpedoLauncher*)a;
+        serializeShipObject(ar, t);
+        ar.value(t->torpedoes);
+        ar.value(t->charge_time);
+        ar.value(t->recharge_time);
+        ar.value(t->max_torpedoes);
+    } break;
+    case ActorType::PDC:
+    {
+        PDC* p = (PDC*)a;
+        serializeShipObject(ar, p);
+        ar.value(p->rounds);
+        ar.value(p->firing_variance);
+        ar.value(p->max_rounds);
+    } break;
+    case ActorType::Railgun:
+    {
+        Railgun* r = (Railgun*)a;
+        serializeShipObject(ar, r);
+        ar.value(r->rounds);
+        ar.value(r->charge_time);
+        ar.value(r->max_rounds);
+        ar.value(r->recharge_time);
+        ar.value(r->firing_variance);
+    } break;
+    default: break;
+    }
+}
+
+// Same tile bookkeeping as Map::spawn, without its placement checks.
+void linkActor(Map* map, Actor* a)
+{
+    ActorInfo& ai = g_game.reg.actor_info[int(a->type)];
+    map->actors.push_back(a);
+    if (!map->tiles.find(a->pos).found)
+        map->tiles.insert(a->pos, Tile(a->pos));
+    auto it = map->tiles.find(a->pos);
+    if (ai.is_ground) it.value.ground = a;
+    else it.value.actor = a;
+    if (a->type == ActorType::Player) map->player = (Player*)a;
+}
+
+void serializeMap(SaveArchive& ar, Map* map)
+{
+    ar.string(map->name);
+    ar.value(map->min);
+    ar.value(map->max);
+    ar.value(map->see_all);
+    ar.value(map->turn);
+
+    u32 tile_capacity = map->tiles.capacity();
+    ar.value(tile_capacity);
+    std::vector<SaveTile> tiles;
+    if (!ar.loading)
+    {
+        tiles.reserve(map->tiles.size());
+        for (auto it : map->tiles)
+            tiles.push_back(SaveTile{ it.key, (u8)it.value.terrain, it.value.explored });
+    }
+    ar.array(tiles, SaveTile{});
+    if (ar.loading)
+    {
+        reserveTable(map->tiles, tile_capacity, (u32)tiles.size());
+        for (const SaveTile& t : tiles)
+        {
+            if (t.terrain >= (u8)Terrain::__COUNT) ar.failed = true;
+            Tile tl(t.pos, (Terrain)t.terrain);
+            tl.explored = t.explored;
+            map->tiles.insert(t.pos, tl);
+        }
+    }
+
+    u32 actor_count = ar.count((u32)map->actors.size(), sizeof(ActorType));
+    for (u32 i = 0; i < actor_count && !ar.failed; ++i)
+    {
+        Actor* a = ar.loading ? nullptr : map->actors[i];
+        ActorType type = a ? a->type : ActorType::Invalid;
+        ar.value(type);
+        if (ar.loading)
+        {
+            a = createActor(type);
+            if (!a)
+            {
+                ar.failed = true;
+                break;
+            }
+        }
+        serializeActor(ar, a);
+        if (ar.loading) linkActor(map, a);
+    }
+}
+
+// The component lists Ship::update builds, without its power rebalancing side effects.
+void linkComponents(Ship* ship)
+{
+    for (Actor* a : ship->map->actors)
+    {
+        switch (a->type)
+        {
+        case ActorType::PilotSeat: ship->pilot = (PilotSeat*)a; break;
+        case ActorType::Scanner: ship->scanner = (Scanner*)a; break;
+        case ActorType::Reactor: ship->reactor = (Reactor*)a; break;
+        case ActorType::Engine: ship->engines.push_back((MainEngine*)a); break;
+        case ActorType::TorpedoLauncher: ship->torpedoes.push_back((TorpedoLauncher*)a); break;
+        case ActorType::PDC: ship->pdcs.push_back((PDC*)a); break;
+        case ActorType::Railgun: ship->railguns.push_back((Railgun*)a); break;
+        default: break;
+        }
+    }
+}
+
+void serializeShip(SaveArchive& ar, Ship* ship)
+{
+    ar.value(ship->hull_integrity);
+    ar.value(ship->max_integrity);
+    ar.value(ship->transponder_masked);
+    ar.array(ship->rooms, ShipRoom(vec2i(), vec2i(), RoomType::Engine));
+    serializeMap(ar, ship->map);
+}
+
+UActor* createUActor(UActorType type)
+{
+    switch (type)
+    {
+    case UActorType::Player: return new UPlayer(vec2i());
+    case UActorType::Asteroid: return new UAsteroid(vec2i(), 0, 0);
+    case UActorType::CargoShip: return new UCargoShip(vec2i());
+    case UActorType::Torpedo: return new UTorpedo(vec2i(), 0);
+    case UActorType::PirateShip: return new UPirateShip(vec2i(), 0, 0);
+    case UActorType::Station: return new UStation(vec2i());
+    case UActorType::ShipWreck: return new UShipWreck(vec2i());
+    case UActorType::MilitaryStation: return new UMilitaryStation(vec2i());
+    default: return nullptr;
+    }
+}
+
+// Ships are referenced by index into ships. When loading each index may only be claimed
+// once, claimed entries are cleared so any left over afterwards were never owned.
+void serializeUShip(SaveArchive& ar, UShip* s, std::vector<Ship*>& ships)
+{
+    ar.value(s->vel());
+    s32 index = -1;
+    if (!ar.loading && s->ship)
+    {
+        auto it = std::find(ships.begin(), ships.end(), s->ship);
+        if (it != ships.end()) index = (s32)(it - ships.begin());
+    }
+    ar.value(index);
+    if (ar.loading && index >= 0)
+    {
+        if (index >= (s32)ships.size() || !ships[index])
+        {
+            ar.failed = true;
+            return;
+        }
+        s->ship = ships[index];
+        ships[index] = nullptr;
+    }
+}
+
+void serializeUActor(SaveArchive& ar, UActor* a, std::vector<Ship*>& ships)
+{
+    ar.value(a->id);
+    ar.value(a->pos());
+    ar.value(a->dead);
+    switch (a->type)
+    {
+    case UActorType::Player:
+    {
+        UPlayer* p = (UPlayer*)a;
+        serializeUShip(ar, p, ships);
+        ar.value(p->railgun_power);
+        ar.value(p->torpedo_power);
+        ar.value(p->torpedoes_launched);
+        ar.value(p->railgun_fired);
+        ar.value(p->stations_visited);
+        ar.value(p->ships_killed);
+        ar.value(p->damage_taken);
+        ar.value(p->credits_spent);
+        ar.value(p->scrap_salvaged);
+    } break;
+    case UActorType::Asteroid:
+    {
+        UAsteroid* ast = (UAsteroid*)a;
+        ar.value(ast->sfreq);
+        ar.value(ast->radius);
+        ar.value(ast->color);
+        ar.value(ast->inner_color);
+    } break;
+    case UActorType::CargoShip:
+    {
+        serializeUShip(ar, (UShip*)a, ships);
+    } break;
+    case UActorType::Torpedo:
+    {
+        UTorpedo* t = (UTorpedo*)a;
+        serializeUShip(ar, t, ships);
+        ar.value(t->target_pos);
+        ar.value(t->target);
+        ar.value(t->source);
+        ar.value(t->power);
+    } break;
+    case UActorType::PirateShip:
+    {
+        UPirateShip* p = (UPirateShip*)a;
+        serializeUShip(ar, p, ships);
+        ar.value(p->character);
+        ar.value(p->color);
+        ar.value(p->target);
+        ar.value(p->target_last_pos);
+        ar.value(p->check_for_target);
+        ar.value(p->torp_reload_cooldown);
+        ar.value(p->torp_max_reloads);
+        ar.value(p->railgun_reload_cooldown);
+        ar.value(p->railgun_max_reloads);
+        ar.value(p->has_alerted);
+        ar.value(p->has_warned);
+        ar.value(p->has_bribed);
+        ar.value(p->railgun_power);
+        ar.value(p->torpedo_power);
+    } break;
+    case UActorType::Station:
+    {
+        UStation* s = (UStation*)a;
+        ar.value(s->upgrades);
+        ar.value(s->repair_cost);
+        ar.value(s->scrap_price);
+        ar.value(s->has_visited);
+    } break;
+    case UActorType::ShipWreck:
+    {
+        ar.value(((UShipWreck*)a)->scrap);
+    } break;
+    case UActorType::MilitaryStation:
+    {
+        UMilitaryStation* m = (UMilitaryStation*)a;
+        ar.value(m->charge_time);
+        ar.value(m->has_warned);
+    } break;
+    default: break;
+    }
+}
+
+void serializeUniverse(SaveArchive& ar, Universe* u, std::vector<Ship*>& ships)
+{
+    ar.value(u->rng);
+    ar.value(u->universe_ticks);
+    ar.value(u->next_actor);
+    ar.value(u->has_spawned_alien);
+
+    u32 region_capacity = u->regions_generated.capacity();
+    ar.value(region_capacity);
+    std::vector<vec2i> regions;
+    if (!ar.loading)
+    {
+        regions.reserve(u->regions_generated.size());
+        for (auto it : u->regions_generated) regions.push_back(it.key);
+    }
+    ar.array(regions, vec2i());
+    if (ar.loading)
+    {
+        reserveTable(u->regions_generated, region_capacity, (u32)regions.size());
+        for (vec2i r : regions) u->regions_generated.insert(r, true);
+    }
+
+    // Actors are written in actor_ids order and reinserted in the same order.
+    std::vector<UActor*> order;
+    if (!ar.loading)
+    {
+        order.reserve(u->actor_ids.size());
+        for (auto it : u->actor_ids) order.push_back(it.value);
+    }
+    u32 actor_capacity = u->actor_ids.capacity();
+    ar.value(actor_capacity);
+    u32 actor_count = ar.count((u32)order.size(), sizeof(UActorType) + sizeof(u32));
+    if (ar.loading) reserveTable(u->actor_ids, actor_capacity, actor_count);
+    for (u32 i = 0; i < actor_count && !ar.failed; ++i)
+    {
+        UActor* a = ar.loading ? nullptr : order[i];
+        UActorType type = a ? a->type : UActorType::__COUNT;
+        ar.value(type);
+        if (ar.loading)
+        {
+            a = createUActor(type);
+            if (!a)
+            {
+                ar.failed = true;
+                break;
+            }
+        }
+        serializeUActor(ar, a, ships);
+        if (ar.loading)
+        {
+            if (u->actor_ids.find(a->id).found)
+            {
+                ar.failed = true;
+                delete a;
+                break;
+            }
+            u->actor_ids.insert(a->id, a);
+        }
+    }
+
+    u32 cell_capacity = u->actors.capacity();
+    ar.value(cell_capacity);
+    std::vector<SaveCell> cells;
+    if (!ar.loading)
+    {
+        cells.reserve(u->actors.size());
+        for (auto it : u->actors) cells.push_back(SaveCell{ it.key, it.value->id });
+    }
+    ar.array(cells, SaveCell{});
+    if (ar.loading)
+    {
+        reserveTable(u->actors, cell_capacity, (u32)cells.size());
+        for (const SaveCell& c : cells)
+        {
+            auto it = u->actor_ids.find(c.id);
+            if (!it.found)
+            {
+                ar.failed = true;
+                break;
+            }
+            u->actors.insert(c.pos, it.value);
+        }
+    }
+
+    std::vector<u32> torpedoes;
+    if (!ar.loading)
+    {
+        torpedoes.reserve(u->torpedoes.size());
+        for (UTorpedo* t : u->torpedoes) torpedoes.push_back(t->id);
+        // Registered in spawn order on load, so the incoming lists come back in the same order.
+        std::sort(torpedoes.begin(), torpedoes.end());
+    }
+    ar.array(torpedoes, 0u);
+    if (ar.loading)
+    {
+        for (u32 id : torpedoes)
+        {
+            auto it = u->actor_ids.find(id);
+            if (!it.found || it.value->type != UActorType::Torpedo)
+            {
+                ar.failed = true;
+                break;
+            }
+            u->addTorpedo((UTorpedo*)it.value);
+        }
+    }
+
+    // Slots are handed out in id order on load, every ship needs one.
+    std::vector<SaveMover> mover_state;
+    if (!ar.loading)
+    {
+        const MoverArrays& m = u->movers;
+        mover_state.reserve(m.size());
+        for (u32 i = 0; i < m.size(); ++i)
+            mover_state.push_back(SaveMover{ m.id[i], m.flags[i], m.track_pos[i], m.track_vel[i] });
+        std::sort(mover_state.begin(), mover_state.end(), [](const SaveMover& a, const SaveMover& b) { return a.id < b.id; });
+    }
+    ar.array(mover_state, SaveMover{});
+    if (ar.loading && !ar.failed)
+    {
+        MoverArrays& m = u->movers;
+        for (const SaveMover& sm : mover_state)
+        {
+            auto it = u->actor_ids.find(sm.id);
+            if (!it.found || !isShipType(it.value->type) || ((UShip*)it.value)->mover_slot != MoverArrays::None)
+            {
+                ar.failed = true;
+                return;
+            }
+            u32 slot = m.add((UShip*)it.value);
+            m.flags[slot] = (u8)sm.flags;
+            m.track_pos[slot] = sm.track_pos;
+            m.track_vel[slot] = sm.track_vel;
+        }
+        for (auto it : u->actor_ids)
+        {
+            if (isShipType(it.value->type) && ((UShip*)it.value)->mover_slot == MoverArrays::None)
+            {
+                ar.failed = true;
+                return;
+            }
+        }
+    }
+}
+
+void serializeGameFields(SaveArchive& ar, SaveGameFields& game)
+{
+    ar.value(game.credits);
+    ar.value(game.scrap);
+    ar.value(game.rng);
+    ar.value(game.show_universe);
+    ar.value(game.last_universe_update);
+}
+
+void writeSnapshot(SaveArchive& ar)
+{
+    u32 magic = SaveMagic, version = SaveVersion;
+    ar.value(magic);
+    ar.value(version);
+
+    SaveGameFields game{ g_game.credits, g_game.scrap, g_game.rng, g_game.show_universe, g_game.last_universe_update };
+    serializeGameFields(ar, game);
+
+    std::vector<Ship*> ships = g_game.ships;
+    ar.count((u32)ships.size(), 0);
+    for (Ship* s : ships) serializeShip(ar, s);
+
+    serializeUniverse(ar, g_game.universe, ships);
+}
+
+bool saveGame(const char* path)
+{
+    PROFILE_ZONE("saveGame");
+    if (!g_game.universe || !g_game.uplayer) return false;
+
+    SaveArchive ar(false);
+    ar.data.reserve(1 << 20);
+    writeSnapshot(ar);
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    bool ok = fwrite(ar.data.data(), 1, ar.data.size(), f) == ar.data.size();
+    fclose(f);
+    return ok;
+}
+
+u64 hashGameState()
+{
+    PROFILE_ZONE("hashGameState");
+    if (!g_game.universe || !g_game.uplayer) return 0;
+
+    SaveArchive ar(false);
+    ar.data.reserve(1 << 20);
+    writeSnapshot(ar);
+
+    u64 hash = 0xcbf29ce484222325ull;
+    for (u8 b : ar.data)
+    {
+        hash ^= b;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool loadGame(const char* path)
+{
+    PROFILE_ZONE("loadGame");
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+
+    SaveArchive ar(true);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    ar.data.resize(size > 0 ? (size_t)size : 0);
+    bool read = fread(ar.data.data(), 1, ar.data.size(), f) == ar.data.size();
+    fclose(f);
+    if (!read) return false;
+
+    u32 magic = 0, version = 0;
+    ar.value(magic);
+    ar.value(version);
+    if (ar.failed || magic != SaveMagic || version != SaveVersion) return false;
+
+    // Station and wreck constructors draw from the game rng, restore it whatever happens.
+    pcg32 game_rng = g_game.rng;
+
+    SaveGameFields game{};
+    serializeGameFields(ar, game);
+
+    std::vector<Ship*> ships;
+    u32 ship_count = ar.count(0, sizeof(int) * 2);
+    for (u32 i = 0; i < ship_count && !ar.failed; ++i)
+    {
+        Ship* ship = new Ship(new Map(""));
+        ships.push_back(ship);
+        serializeShip(ar, ship);
+        linkComponents(ship);
+    }
+
+    Universe* universe = new Universe;
+    std::vector<Ship*> unclaimed = ships;
+    if (!ar.failed) serializeUniverse(ar, universe, unclaimed);
+
+    g_game.rng = game_rng;
+
+    UPlayer* uplayer = nullptr;
+    for (auto it : universe->actor_ids)
+    {
+        if (it.value->type == UActorType::Player) uplayer = (UPlayer*)it.value;
+    }
+    bool complete = !ar.failed && ar.cursor == ar.data.size() && uplayer && uplayer->ship;
+    for (Ship* s : unclaimed) complete = complete && !s;
+    if (!complete)
+    {
+        for (Ship* s : unclaimed)
+        {
+            if (!s) continue;
+            delete s->map;
+            delete s;
+        }
+        // Claimed ships are owned, and freed, by their universe actors.
+        delete universe;
+        return false;
+    }
+
+    delete g_game.universe;
+    delete g_game.modal;
+    g_game.modal = nullptr;
+
+    g_game.universe = universe;
+    g_game.ships = ships;
+    g_game.uplayer = uplayer;
+    g_game.player_ship = uplayer->ship;
+    g_game.current_level = g_game.player_ship->map;
+
+    g_game.credits = game.credits;
+    g_game.scrap = game.scrap;
+    g_game.rng = game.rng;
+    g_game.show_universe = game.show_universe;
+    g_game.last_universe_update = game.last_universe_update;
+    g_game.transition = 0.0f;
+    g_game.is_aiming_hail = false;
+
+    g_game.animations.clear();
+    g_game.uanimations.clear();
+    g_game.state = GameState::Ingame;
+    return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Binary snapshot of a running game: the universe, every ship's map and the Game fields.
+// The whole file is built in memory and written or read with a single call. Saves from
+// another version are rejected.
+constexpr u32 SaveMagic = 0x56415353; // "SSAV"
+constexpr u32 SaveVersion = 4;
+
+bool saveGame(const char* path);
+// Replaces the current game with the one in path. The current game is left untouched on failure.
+bool loadGame(const char* path);
+
+// Hash of the snapshot saveGame would write, replays compare it at checkpoints.
+u64 hashGameState();
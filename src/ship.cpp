@@ -6,14 +6,51 @@
 #include "sound.h"
 #include "universe.h"
 
-ShipRoom* Ship::getRoom(vec2i p)
+void Ship::indexRooms()
 {
+    room_index_count = (int)rooms.size();
+    room_index.clear();
+    if (rooms.empty())
+    {
+        room_index_size = vec2i();
+        return;
+    }
+
+    vec2i lo = rooms[0].min;
+    vec2i hi = rooms[0].max;
     for (auto& r : rooms)
     {
-        if (p.x >= r.min.x && p.x <= r.max.x && p.y >= r.min.y && p.y <= r.max.y)
-            return &r;
+        lo = ::min(lo, r.min);
+        hi = ::max(hi, r.max);
     }
-    return nullptr;
+    room_index_min = lo;
+    room_index_size = hi - lo + vec2i(1, 1);
+    room_index.resize(room_index_size.x * room_index_size.y, -1);
+
+    // Rooms share their walls, walk backwards so the first room in the list
+    // wins a shared tile just like the old linear scan did.
+    for (int i = (int)rooms.size() - 1; i >= 0; --i)
+    {
+        ShipRoom& r = rooms[i];
+        for (int y = r.min.y; y <= r.max.y; ++y)
+        {
+            s16* row = &room_index[(y - lo.y) * room_index_size.x];
+            for (int x = r.min.x; x <= r.max.x; ++x)
+                row[x - lo.x] = (s16)i;
+        }
+    }
+}
+
+ShipRoom* Ship::getRoom(vec2i p)
+{
+    if (room_index_count != (int)rooms.size())
+        indexRooms();
+
+    vec2i l = p - room_index_min;
+    if (l.x < 0 || l.y < 0 || l.x >= room_index_size.x || l.y >= room_index_size.y)
+        return nullptr;
+    s16 idx = room_index[l.x + l.y * room_index_size.x];
+    return idx < 0 ? nullptr : &rooms[idx];
 }
 
 ShipRoom* Ship::getRoom(RoomType t)
@@ -162,26 +199,28 @@ void Ship::update()
     }
 }
 
-void Ship::explosion(vec2f d, float power)
+DamageResult Ship::explosion(vec2f d, float power)
 {
     if (!map)
     {
         hull_integrity = 0;
-        return;
+        return DamageResult();
     }
     vec2i center = (map->max + map->min) / 2;
-    std::vector<vec2i> ray = map->findRay(center + (d * (map->max - center).length()).cast<int>(), center);
+    frame_vector<vec2i> ray = map->findRay(center + (d * (map->max - center).length()).cast<int>(), center);
     vec2i p = ray.back();
-    explosionAt(p, power);
+    return explosionAt(p, power);
 }
 
-void Ship::damageTile(vec2i p)
+void Ship::damageTiles(const vec2i* cells, int count, DamageResult& result)
 {
-    auto it = map->tiles.find(p);
-    if (it.found)
+    int damage = 0;
+    for (int i = 0; i < count; ++i)
     {
-        hull_integrity--;
-        if (this == g_game.player_ship) g_game.uplayer->damage_taken++;
+        auto it = map->tiles.find(cells[i]);
+        if (!it.found) continue;
+
+        damage++;
         if (it.value.terrain == Terrain::ShipWall)
             it.value.terrain = Terrain::DamagedShipWall;
         else if (it.value.terrain == Terrain::ShipFloor)
@@ -198,51 +237,99 @@ void Ship::damageTile(vec2i p)
             case ActorType::Railgun:
             {
                 ShipObject* obj = (ShipObject*)it.value.actor;
-                obj->status = ShipObject::Status::Damaged;
+                if (obj->status != ShipObject::Status::Damaged)
+                {
+                    obj->status = ShipObject::Status::Damaged;
+                    result.damaged_components.push_back(obj);
+                }
             } break;
             }
         }
     }
+
+    hull_integrity -= damage;
+    result.hull_damage += damage;
+    if (this == g_game.player_ship) g_game.uplayer->damage_taken += damage;
 }
 
-void Ship::explosionAt(vec2i p, float power)
+struct DamageStencil
 {
+    // Cells within the radius in row-major order, matching the order the
+    // random thresholds are drawn in.
+    std::vector<vec2i> offsets;
+    std::vector<float> distance;
+};
+
+const DamageStencil& getDamageStencil(int r)
+{
+    static std::vector<DamageStencil> stencils;
+    if (r >= (int)stencils.size())
+        stencils.resize(r + 1);
+
+    DamageStencil& s = stencils[r];
+    if (s.offsets.empty())
+    {
+        for (int y = -r; y <= r; ++y)
+        {
+            for (int x = -r; x <= r; ++x)
+            {
+                int d2 = x * x + y * y;
+                if (d2 > r * r) continue;
+                s.offsets.push_back(vec2i(x, y));
+                s.distance.push_back(sqrtf(float(d2)));
+            }
+        }
+    }
+    return s;
+}
+
+DamageResult Ship::explosionAt(vec2i p, float power)
+{
+    DamageResult result;
     if (!map)
     {
         hull_integrity = 0;
-        return;
+        return result;
     }
     int r = scalar::ceili(power);
-    for (int y = -r; y <= r; ++y)
+    const DamageStencil& stencil = getDamageStencil(r);
+    int count = (int)stencil.offsets.size();
+
+    static std::vector<float> thresholds;
+    static std::vector<vec2i> cells;
+    thresholds.resize(count);
+    cells.clear();
+
+    for (int i = 0; i < count; ++i)
+        thresholds[i] = g_game.rng.nextFloat();
+
+    for (int i = 0; i < count; ++i)
     {
-        for (int x = -r; x <= r; ++x)
-        {
-            int d2 = x * x + y * y;
-            if (d2 > r * r) continue;
-            float chance = 1 - sqrtf(x * x + y * y) / power;
-            chance *= chance;
-            if (g_game.rng.nextFloat() > chance) continue;
-            damageTile(p + vec2i(x, y));
-        }
+        float chance = 1 - stencil.distance[i] / power;
+        chance *= chance;
+        if (thresholds[i] > chance) continue;
+        cells.push_back(p + stencil.offsets[i]);
     }
+    damageTiles(cells.data(), (int)cells.size(), result);
 
     if (this == g_game.player_ship)
     {
         for (int i = 0; i < 3; ++i)
         {
             vec2i c = p + vec2i(g_game.rng.nextInt(-3, 3), g_game.rng.nextInt(-3, 3));
-            ExplosionAnimation* e = new ExplosionAnimation(c, scalar::ceili(power + g_game.rng.nextFloat() * 3 - 1.5f));
-            g_game.animations.push_back(e);
+            g_game.animations.explosion(c, scalar::ceili(power + g_game.rng.nextFloat() * 3 - 1.5f));
         }
     }
+    return result;
 }
 
-void Ship::railgun(vec2i d, int power)
+DamageResult Ship::railgun(vec2i d, int power)
 {
+    DamageResult result;
     if (!map)
     {
         hull_integrity = 0;
-        return;
+        return result;
     }
     vec2i f, t;
     vec2i a;
@@ -292,15 +379,19 @@ void Ship::railgun(vec2i d, int power)
     }
 
     auto points = findRay(f, t);
+    static std::vector<vec2i> cells;
+    cells.clear();
     for (vec2i p : points)
     {
-        damageTile(p);
+        cells.push_back(p);
         for (int j = 1; j < power; ++j)
         {
-            damageTile(p + a * j);
-            damageTile(p + a * -j);
+            cells.push_back(p + a * j);
+            cells.push_back(p + a * -j);
         }
     }
+    damageTiles(cells.data(), (int)cells.size(), result);
+    return result;
 }
 
 float Ship::scannerRange() const
@@ -15,6 +15,7 @@ struct Scanner;
 struct TorpedoLauncher;
 struct PDC;
 struct Railgun;
+struct ShipObject;
 
 enum class RoomType
 {
@@ -38,11 +39,23 @@ struct ShipRoom
     ShipRoom(vec2i min, vec2i max, RoomType type) : min(min), max(max), type(type) {}
 };
 
+struct DamageResult
+{
+    int hull_damage = 0;
+    std::vector<ShipObject*> damaged_components;
+};
+
 struct Ship
 {
     Map* map;
     std::vector<ShipRoom> rooms;
 
+    // Per-tile index into rooms covering the rooms' bounding box, -1 where
+    // there is no room. Rebuilt whenever the room count changes.
+    std::vector<s16> room_index;
+    vec2i room_index_min, room_index_size;
+    int room_index_count = -1;
+
     std::vector<MainEngine*> engines;
     Reactor* reactor = nullptr;
     PilotSeat* pilot = nullptr;
@@ -58,6 +71,7 @@ struct Ship
 
     Ship(Map* map) : map(map) {}
 
+    void indexRooms();
     ShipRoom* getRoom(vec2i p);
     ShipRoom* getRoom(RoomType t);
 
@@ -65,10 +79,11 @@ struct Ship
 
     void update();
 
-    void damageTile(vec2i p);
-    void explosion(vec2f d, float power);
-    void explosionAt(vec2i p, float power);
-    void railgun(vec2i d, int power);
+    // Applies one point of damage per entry in cells (duplicates hit twice) in a single pass over the map.
+    void damageTiles(const vec2i* cells, int count, DamageResult& result);
+    DamageResult explosion(vec2f d, float power);
+    DamageResult explosionAt(vec2i p, float power);
+    DamageResult railgun(vec2i d, int power);
 
     float scannerRange() const;
 
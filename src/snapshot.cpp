@@ -0,0 +1,66 @@
+#include "snapshot.h"
+
+#include "profiler.h"
+#include "window.h"
+
+void SnapshotBuffer::publish()
+{
+    back_index = middle.exchange(back_index | Fresh, std::memory_order_acq_rel) & ~Fresh;
+}
+
+const RenderSnapshot& SnapshotBuffer::latest()
+{
+    if (middle.load(std::memory_order_relaxed) & Fresh)
+        front_index = middle.exchange(front_index, std::memory_order_acq_rel) & ~Fresh;
+    return slots[front_index];
+}
+
+void drawCover(const RenderSnapshot& s, const Texture& cover, int dw, int dh)
+{
+    Rectangle dest{ dw / 2.0f, dh / 2.0f, s.w * 16.0f, s.h * 16.0f };
+    Rectangle src{ 0.0f, 0.0f, (float)cover.width, (float)cover.height };
+    DrawTexturePro(cover, src, dest, Vector2(), 0.0f, WHITE);
+}
+
+void drawRenderSnapshot(const RenderSnapshot& s, const Texture& cover)
+{
+    PROFILE_ZONE("drawRenderSnapshot");
+    if (s.tick == 0)
+    {
+        ClearBackground(BLACK);
+        return;
+    }
+
+    int dw = g_window.width - s.w * 16;
+    int dh = g_window.height - s.h * 16;
+
+    if (s.menu_scene)
+    {
+        ClearBackground(Color{ 0x20, 0x20, 0x20, 0xFF });
+        render_buffer(&s.map, s.map_zoom);
+        drawCover(s, cover, dw, dh);
+
+        BeginScissorMode(dw / 2, dh / 2, s.w * 16, s.h * 16);
+        render_buffer(&s.menu, 1.0f);
+        EndScissorMode();
+    }
+    else
+    {
+        ClearBackground(BLACK);
+        BeginScissorMode(dw / 2, dh / 2, s.w * 16, s.h * 16);
+
+        render_buffer(&s.map, s.map_zoom);
+        if (s.draw_ui)
+            render_buffer(&s.ui, 1.0f);
+        if (s.draw_menu)
+        {
+            drawCover(s, cover, dw, dh);
+            render_buffer(&s.menu, 1.0f);
+        }
+
+        EndScissorMode();
+    }
+
+    if (s.draw_debug)
+        render_buffer(&s.debug, 1.0f);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <atomic>
+
+#include "vterm.h"
+
+// Everything the render thread needs to draw one sim tick. The sim thread composes into its
+// own terminals and copies them here, the render thread only ever reads a published snapshot.
+struct RenderSnapshot
+{
+    u64 tick = 0;
+    int w = 0, h = 0;
+    float map_zoom = 1.0f;
+
+    // The main menu draws the map unclipped on a grey background with the cover over it,
+    // in game the cover and menu layer only show over the paused map.
+    bool menu_scene = false;
+    bool draw_ui = false;
+    bool draw_menu = false;
+    bool draw_debug = false;
+
+    TextBuffer map{ 1, 1 };
+    TextBuffer ui{ 1, 1 };
+    TextBuffer menu{ 1, 1 };
+    TextBuffer debug{ 1, 1 };
+};
+
+// Lock free triple buffer. The writer fills back() and publishes it, the reader takes the
+// newest published snapshot and keeps drawing it until a newer one arrives.
+struct SnapshotBuffer
+{
+    static constexpr int Fresh = 4;
+
+    RenderSnapshot slots[3];
+    // The slot between writer and reader, with Fresh set while the reader has not taken it.
+    std::atomic<int> middle = 1;
+    int back_index = 0;
+    int front_index = 2;
+
+    RenderSnapshot& back() { return slots[back_index]; }
+    void publish();
+    // True if a snapshot was published since the last call to latest().
+    bool fresh() const { return middle.load(std::memory_order_acquire) & Fresh; }
+    const RenderSnapshot& latest();
+};
+
+// Draws a snapshot with raylib, cover is the title image shown behind menus.
+void drawRenderSnapshot(const RenderSnapshot& s, const Texture& cover);
@@ -1,10 +1,56 @@
 #include "sound.h"
 
+#include <atomic>
+#include <chrono>
+
+#include "assets.h"
 #include "game.h"
+#include "profiler.h"
+
+constexpr int SoundMaxVoices = 4;
+
+// Voices an effect may play at once, past that the oldest voice is restarted.
+const int sound_voice_limits[SoundEffectCount] = {
+    3, // AsteroidImpact
+    4, // PDCFire
+    2, // RailgunFire
+    3, // RailgunImpact
+    1, // ReactorShutdown
+    1, // ReactorStartup
+    3, // TorpedoImpact
+    3, // TorpedoLaunch
+};
+
+const char* sound_effect_assets[SoundEffectCount] = {
+    "asteroid_impact.wav",
+    "pdc_fire.wav",
+    "railgun_fire.wav",
+    "railgun_impact.wav",
+    "reactor_shutdown.wav",
+    "reactor_start.wav",
+    "torpedo_impact.wav",
+    "torpedo_launch.wav",
+};
+
+struct SoundVoices
+{
+    Sound voices[SoundMaxVoices];
+    u64 started[SoundMaxVoices] = {};
+    // Zero until the wave has been decoded, the effect is silent until then.
+    int count = 0;
+    std::shared_future<Wave> wave;
+};
 
 struct Sounds
 {
-    Sound effects[SoundEffectCount];
+    SoundBackend backend = SoundBackend::Null;
+    SoundStats stats;
+    u64 drains = 0;
+
+    // Plays requested since the last drain, one counter per effect so the queue never fills.
+    std::atomic<u32> pending[SoundEffectCount] = {};
+
+    SoundVoices effects[SoundEffectCount];
     Music music[2];
     int active_music = 0;
 
@@ -13,31 +59,42 @@ struct Sounds
 };
 Sounds g_sounds;
 
-void initSounds()
+// Turns decoded waves into sounds. After initSounds the audio device is only touched from the
+// thread calling updateSounds, the sim thread unless it runs inline.
+void finishLoadingEffects()
 {
-    InitAudioDevice();
-
-    g_sounds.effects[int(SoundEffect::AsteroidImpact)] = LoadSound("assets/asteroid_impact.wav");
-    g_sounds.effects[int(SoundEffect::PDCFire)] = LoadSound("assets/pdc_fire.wav");
-    g_sounds.effects[int(SoundEffect::RailgunFire)] = LoadSound("assets/railgun_fire.wav");
-    g_sounds.effects[int(SoundEffect::RailgunImpact)] = LoadSound("assets/railgun_impact.wav");
-    g_sounds.effects[int(SoundEffect::ReactorShutdown)] = LoadSound("assets/reactor_shutdown.wav");
-    g_sounds.effects[int(SoundEffect::ReactorStartup)] = LoadSound("assets/reactor_start.wav");
-    g_sounds.effects[int(SoundEffect::TorpedoImpact)] = LoadSound("assets/torpedo_impact.wav");
-    g_sounds.effects[int(SoundEffect::TorpedoLaunch)] = LoadSound("assets/torpedo_launch.wav");
-
-    g_sounds.music[0] = LoadMusicStream("assets/levelloopmaybe.wav");
-    g_sounds.music[1] = LoadMusicStream("assets/levelloopmaybedrumver.wav");
+    for (int i = 0; i < SoundEffectCount; i++)
+    {
+        SoundVoices& v = g_sounds.effects[i];
+        if (!v.wave.valid() || v.wave.wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+        Wave wave = v.wave.get();
+        v.wave = std::shared_future<Wave>();
+        v.voices[0] = LoadSoundFromWave(wave);
+        UnloadWave(wave);
+        v.count = scalar::min(sound_voice_limits[i], SoundMaxVoices);
+        for (int j = 0; j < v.count; j++)
+        {
+            if (j > 0) v.voices[j] = LoadSoundAlias(v.voices[0]);
+            SetSoundVolume(v.voices[j], g_sounds.sound_volume / 10.0f);
+        }
+    }
+}
 
-    if (g_game.sound_volume != g_sounds.sound_volume)
+void applyVolumes(bool force)
+{
+    if (force || g_game.sound_volume != g_sounds.sound_volume)
     {
         g_sounds.sound_volume = g_game.sound_volume;
         for (int i = 0; i < SoundEffectCount; i++)
         {
-            SetSoundVolume(g_sounds.effects[i], g_sounds.sound_volume / 10.0f);
+            SoundVoices& v = g_sounds.effects[i];
+            for (int j = 0; j < v.count; j++)
+            {
+                SetSoundVolume(v.voices[j], g_sounds.sound_volume / 10.0f);
+            }
         }
     }
-    if (g_game.music_volume != g_sounds.music_volume)
+    if (force || g_game.music_volume != g_sounds.music_volume)
     {
         g_sounds.music_volume = g_game.music_volume;
         for (int i = 0; i < 2; i++)
@@ -45,28 +102,64 @@ void initSounds()
             SetMusicVolume(g_sounds.music[i], (g_sounds.music_volume / 10.0f) * 0.4f);
         }
     }
+}
+
+void initSounds(SoundBackend backend)
+{
+    g_sounds.backend = SoundBackend::Null;
+    if (backend == SoundBackend::Null) return;
+
+    InitAudioDevice();
+    if (!IsAudioDeviceReady()) return;
+    g_sounds.backend = SoundBackend::Audio;
+
+    for (int i = 0; i < SoundEffectCount; i++)
+    {
+        g_sounds.effects[i].wave = loadAssetWaveAsync(sound_effect_assets[i]);
+    }
+
+    g_sounds.music[0] = loadAssetMusic("levelloopmaybe.wav");
+    g_sounds.music[1] = loadAssetMusic("levelloopmaybedrumver.wav");
+
+    applyVolumes(true);
 
     PlayMusicStream(g_sounds.music[0]);
 }
 
-void updateSounds()
+void playVoice(SoundVoices& v)
 {
-    if (g_game.sound_volume != g_sounds.sound_volume)
+    if (v.count == 0) return;
+    int voice = 0;
+    for (int i = 0; i < v.count; i++)
     {
-        g_sounds.sound_volume = g_game.sound_volume;
-        for (int i = 0; i < SoundEffectCount; i++)
+        if (!IsSoundPlaying(v.voices[i]))
         {
-            SetSoundVolume(g_sounds.effects[i], g_sounds.sound_volume / 10.0f);
+            voice = i;
+            break;
         }
+        if (v.started[i] < v.started[voice]) voice = i;
     }
-    if (g_game.music_volume != g_sounds.music_volume)
+    v.started[voice] = g_sounds.drains;
+    PlaySound(v.voices[voice]);
+}
+
+void updateSounds()
+{
+    PROFILE_ZONE("updateSounds");
+    g_sounds.drains++;
+    bool audio = g_sounds.backend == SoundBackend::Audio;
+    if (audio) finishLoadingEffects();
+    for (int i = 0; i < SoundEffectCount; i++)
     {
-        g_sounds.music_volume = g_game.music_volume;
-        for (int i = 0; i < 2; i++)
-        {
-            SetMusicVolume(g_sounds.music[i], (g_sounds.music_volume / 10.0f) * 0.4f);
-        }
+        u32 count = g_sounds.pending[i].exchange(0, std::memory_order_acquire);
+        if (count == 0) continue;
+        g_sounds.stats.requested[i] += count;
+        g_sounds.stats.played[i]++;
+        if (audio) playVoice(g_sounds.effects[i]);
     }
+    if (!audio) return;
+
+    applyVolumes(false);
 
     UpdateMusicStream(g_sounds.music[g_sounds.active_music]);
     float pct = GetMusicTimePlayed(g_sounds.music[g_sounds.active_music]) / GetMusicTimeLength(g_sounds.music[g_sounds.active_music]);
@@ -78,7 +171,12 @@ void updateSounds()
     }
 }
 
+const SoundStats& soundStats()
+{
+    return g_sounds.stats;
+}
+
 void playSound(SoundEffect effect)
 {
-    PlaySound(g_sounds.effects[int(effect)]);
+    g_sounds.pending[int(effect)].fetch_add(1, std::memory_order_relaxed);
 }
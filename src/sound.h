@@ -15,7 +15,26 @@ enum class SoundEffect
 };
 constexpr int SoundEffectCount = int(SoundEffect::__COUNT);
 
-void initSounds();
+enum class SoundBackend
+{
+    // No audio device, events are only counted. Used for headless runs.
+    Null,
+    Audio,
+};
+
+// Totals since initSounds, kept by every backend.
+struct SoundStats
+{
+    u64 requested[SoundEffectCount] = {};
+    u64 played[SoundEffectCount] = {};
+};
+
+// Falls back to the null backend if the audio device cannot be opened.
+void initSounds(SoundBackend backend);
+// Plays the sounds queued since the last call, once per frame and always from the same thread.
 void updateSounds();
+const SoundStats& soundStats();
 
+// Queues an effect, safe to call from any thread. Repeats of an effect within a frame are
+// played once.
 void playSound(SoundEffect effect);
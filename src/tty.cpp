@@ -0,0 +1,586 @@
+#include "tty.h"
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#define NOUSER
+#include <windows.h>
+#else
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+#include "profiler.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "vterm.h"
+
+struct Tty
+{
+    bool open = false;
+#if defined(_WIN32)
+    HANDLE in = nullptr, out = nullptr;
+    DWORD in_mode = 0, out_mode = 0;
+    UINT out_cp = 0;
+#else
+    termios saved{};
+#endif
+
+    // What the terminal shows and what the next frame should show.
+    int cols = 0, rows = 0;
+    std::vector<TtyCell> front, back;
+
+    // Cursor position and colours the terminal is in, -1 when unknown.
+    int cursor_x = -1, cursor_y = -1;
+    s64 cur_fg = -1, cur_bg = -1;
+
+    std::vector<char> out_buf;
+    // Bytes read that do not yet make up a whole key sequence, and whether they were already
+    // left over from the previous poll.
+    std::vector<u8> in_buf;
+    bool in_stalled = false;
+    s16 mouse_x = 0, mouse_y = 0;
+};
+Tty g_tty;
+
+// Unicode for the font's special characters, indexed by SpecialChars.
+const u32 special_glyphs[MaxSpecialChars] = {
+    ' ',
+    0x2502, 0x2500, 0x2510, 0x250C, 0x2518, 0x2514, // Border_Vertical .. Border_BottomLeft
+    0x2524, 0x2534, 0x252C, 0x251C, 0x253C,         // Border_TeeLeft .. Border_Cross
+    0x2191, 0x2193, 0x2190, 0x2192,                 // Arrow_Up .. Arrow_Right
+    0x2665,                                         // Heart
+    0x25E4, 0x25E3, 0x25E5, 0x25E2,                 // LeftDiagTop .. RightDiagBottom
+    0x25E2, 0x25E5, 0x25E3, 0x25E4,                 // LeftDiagTopInverse .. RightDiagBottomInverse
+    0x2588, 0x2580, 0x2584,                         // FullChar, HalfTop, HalfBottom
+};
+
+u32 glyphFor(int c)
+{
+    if (c > 0 && c < MaxSpecialChars) return special_glyphs[c];
+    if (c >= 32 && c < 127) return (u32)c;
+    return '?';
+}
+
+// Colours are 0xAARRGGBB, over is drawn on top of under with its alpha.
+u32 blendColor(u32 over, u32 under)
+{
+    u32 a = over >> 24;
+    if (a == 0xFF) return over & 0xFFFFFF;
+    u32 r = (((over >> 16) & 0xFF) * a + ((under >> 16) & 0xFF) * (255 - a)) / 255;
+    u32 g = (((over >> 8) & 0xFF) * a + ((under >> 8) & 0xFF) * (255 - a)) / 255;
+    u32 b = ((over & 0xFF) * a + (under & 0xFF) * (255 - a)) / 255;
+    return (r << 16) | (g << 8) | b;
+}
+
+// Mirrors render_buffer: background, then glyphs, then the overlay, per cell.
+void composeLayer(const TextBuffer& t, std::vector<TtyCell>& cells, int cols, int rows)
+{
+    for (int y = 0; y < t.h; ++y)
+    {
+        int row = t.invert ? t.h - y : y;
+        if (row < 0 || row >= rows) continue;
+        for (int x = 0; x < t.w && x * 2 + 1 < cols; ++x)
+        {
+            const TextBuffer::Char& ch = t.buffer[x + y * t.w];
+            TtyCell* cell = &cells[x * 2 + row * cols];
+
+            if ((ch.bg & 0xFFFFFF) != 0)
+            {
+                bool opaque = (ch.bg >> 24) == 0xFF;
+                for (int j = 0; j < 2; ++j)
+                {
+                    cell[j].bg = blendColor(ch.bg, cell[j].bg);
+                    if (opaque) cell[j].glyph = ' ';
+                    else cell[j].fg = blendColor(ch.bg, cell[j].fg);
+                }
+            }
+
+            if (ch.text[0] > TileEmpty)
+            {
+                // Every tile in use is a solid block, drawn as background so it needs no glyph.
+                if ((ch.color[0] >> 24) != 0)
+                {
+                    for (int j = 0; j < 2; ++j)
+                    {
+                        cell[j].bg = blendColor(ch.color[0], cell[j].bg);
+                        cell[j].glyph = ' ';
+                    }
+                }
+            }
+            else if (ch.text[1] == 0xFFFF)
+            {
+                if (ch.text[0] != TileEmpty && ch.text[0] != 0 && (ch.color[0] >> 24) != 0)
+                {
+                    cell[0].glyph = glyphFor(ch.text[0]);
+                    cell[0].fg = blendColor(ch.color[0], cell[0].bg);
+                    cell[1].glyph = ' ';
+                }
+            }
+            else
+            {
+                for (int j = 0; j < 2; ++j)
+                {
+                    if (ch.text[j] == TileEmpty || ch.text[j] == 0 || (ch.color[j] >> 24) == 0) continue;
+                    cell[j].glyph = glyphFor(ch.text[j]);
+                    cell[j].fg = blendColor(ch.color[j], cell[j].bg);
+                }
+            }
+
+            if ((ch.overlay & 0xFFFFFF) != 0)
+            {
+                for (int j = 0; j < 2; ++j)
+                {
+                    cell[j].bg = blendColor(ch.overlay, cell[j].bg);
+                    cell[j].fg = blendColor(ch.overlay, cell[j].fg);
+                }
+            }
+        }
+    }
+}
+
+// The layers drawRenderSnapshot draws, in the same order. The cover image and map zoom
+// have no terminal equivalent and are left out.
+void composeSnapshot(const RenderSnapshot& s, std::vector<TtyCell>& cells, int cols, int rows)
+{
+    TtyCell clear;
+    clear.bg = s.menu_scene ? 0x202020 : 0;
+    cells.assign((size_t)cols * rows, clear);
+    if (s.tick == 0) return;
+
+    composeLayer(s.map, cells, cols, rows);
+    if (s.draw_ui) composeLayer(s.ui, cells, cols, rows);
+    if (s.draw_menu) composeLayer(s.menu, cells, cols, rows);
+    if (s.draw_debug) composeLayer(s.debug, cells, cols, rows);
+
+    // A blank shows no foreground, so it must not count as a change.
+    for (TtyCell& c : cells)
+    {
+        if (c.glyph == ' ') c.fg = 0;
+    }
+}
+
+void emit(const char* s)
+{
+    g_tty.out_buf.insert(g_tty.out_buf.end(), s, s + strlen(s));
+}
+
+void emitf(const char* fmt, ...)
+{
+    char buf[64];
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    if (n > 0) g_tty.out_buf.insert(g_tty.out_buf.end(), buf, buf + scalar::min(n, (int)sizeof(buf) - 1));
+}
+
+void emitGlyph(u32 c)
+{
+    std::vector<char>& o = g_tty.out_buf;
+    if (c < 0x80)
+    {
+        o.push_back((char)c);
+    }
+    else if (c < 0x800)
+    {
+        o.push_back((char)(0xC0 | (c >> 6)));
+        o.push_back((char)(0x80 | (c & 0x3F)));
+    }
+    else
+    {
+        o.push_back((char)(0xE0 | (c >> 12)));
+        o.push_back((char)(0x80 | ((c >> 6) & 0x3F)));
+        o.push_back((char)(0x80 | (c & 0x3F)));
+    }
+}
+
+// Only sends the colours that change. A space shows no foreground, so it keeps the current one.
+void emitColors(const TtyCell& c)
+{
+    bool fg = c.glyph != ' ' && c.fg != g_tty.cur_fg;
+    bool bg = c.bg != g_tty.cur_bg;
+    if (fg && bg)
+        emitf("\x1b[38;2;%u;%u;%u;48;2;%u;%u;%um", (c.fg >> 16) & 0xFF, (c.fg >> 8) & 0xFF, c.fg & 0xFF, (c.bg >> 16) & 0xFF, (c.bg >> 8) & 0xFF, c.bg & 0xFF);
+    else if (fg)
+        emitf("\x1b[38;2;%u;%u;%um", (c.fg >> 16) & 0xFF, (c.fg >> 8) & 0xFF, c.fg & 0xFF);
+    else if (bg)
+        emitf("\x1b[48;2;%u;%u;%um", (c.bg >> 16) & 0xFF, (c.bg >> 8) & 0xFF, c.bg & 0xFF);
+    if (fg) g_tty.cur_fg = c.fg;
+    if (bg) g_tty.cur_bg = c.bg;
+}
+
+bool sameColors(const TtyCell& c)
+{
+    return c.bg == g_tty.cur_bg && (c.glyph == ' ' || c.fg == g_tty.cur_fg);
+}
+
+// Picks the shortest way to get the cursor to (x, y), which may be reprinting a few unchanged
+// cells that are already in the current colours.
+void moveCursor(int x, int y)
+{
+    Tty& t = g_tty;
+    if (t.cursor_y == y && t.cursor_x == x) return;
+    if (t.cursor_y == y && t.cursor_x >= 0 && x > t.cursor_x)
+    {
+        int gap = x - t.cursor_x;
+        bool reprint = gap <= 3;
+        for (int i = t.cursor_x; reprint && i < x; ++i)
+        {
+            const TtyCell& c = t.front[i + y * t.cols];
+            reprint = c.glyph < 0x80 && sameColors(c);
+        }
+        if (reprint)
+        {
+            for (int i = t.cursor_x; i < x; ++i)
+                emitGlyph(t.front[i + y * t.cols].glyph);
+        }
+        else if (gap == 1)
+            emit("\x1b[C");
+        else
+            emitf("\x1b[%dC", gap);
+    }
+    else if (x == 0 && t.cursor_y >= 0 && y == t.cursor_y + 1)
+    {
+        emit("\r\n");
+    }
+    else
+    {
+        emitf("\x1b[%d;%dH", y + 1, x + 1);
+    }
+    t.cursor_x = x;
+    t.cursor_y = y;
+}
+
+void writeOut()
+{
+    std::vector<char>& o = g_tty.out_buf;
+    if (o.empty()) return;
+#if defined(_WIN32)
+    DWORD written = 0;
+    WriteFile(g_tty.out, o.data(), (DWORD)o.size(), &written, nullptr);
+#else
+    size_t done = 0;
+    while (done < o.size())
+    {
+        ssize_t n = write(STDOUT_FILENO, o.data() + done, o.size() - done);
+        if (n <= 0) break;
+        done += (size_t)n;
+    }
+#endif
+    o.clear();
+}
+
+vec2i terminalSize()
+{
+#if defined(_WIN32)
+    CONSOLE_SCREEN_BUFFER_INFO info;
+    if (GetConsoleScreenBufferInfo(g_tty.out, &info))
+        return vec2i(info.srWindow.Right - info.srWindow.Left + 1, info.srWindow.Bottom - info.srWindow.Top + 1);
+#else
+    winsize ws{};
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_col > 0)
+        return vec2i(ws.ws_col, ws.ws_row);
+#endif
+    return vec2i(160, 45);
+}
+
+bool ttyOpen()
+{
+    if (g_tty.open) return true;
+#if defined(_WIN32)
+    g_tty.in = GetStdHandle(STD_INPUT_HANDLE);
+    g_tty.out = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (!GetConsoleMode(g_tty.in, &g_tty.in_mode) || !GetConsoleMode(g_tty.out, &g_tty.out_mode)) return false;
+    g_tty.out_cp = GetConsoleOutputCP();
+    SetConsoleOutputCP(CP_UTF8);
+    SetConsoleMode(g_tty.in, ENABLE_VIRTUAL_TERMINAL_INPUT | ENABLE_EXTENDED_FLAGS);
+    if (!SetConsoleMode(g_tty.out, g_tty.out_mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING | DISABLE_NEWLINE_AUTO_RETURN))
+    {
+        SetConsoleMode(g_tty.in, g_tty.in_mode);
+        return false;
+    }
+#else
+    if (!isatty(STDIN_FILENO) || !isatty(STDOUT_FILENO)) return false;
+    if (tcgetattr(STDIN_FILENO, &g_tty.saved) != 0) return false;
+    termios raw = g_tty.saved;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_oflag &= ~OPOST;
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSAFLUSH, &raw) != 0) return false;
+#endif
+    g_tty.open = true;
+    atexit(ttyClose);
+
+    // Alternate screen, hidden cursor, no autowrap, click reporting in SGR form.
+    emit("\x1b[?1049h\x1b[?25l\x1b[?7l\x1b[?1000h\x1b[?1006h");
+    writeOut();
+    return true;
+}
+
+void ttyClose()
+{
+    if (!g_tty.open) return;
+    g_tty.open = false;
+    emit("\x1b[?1006l\x1b[?1000l\x1b[?7h\x1b[0m\x1b[?25h\x1b[?1049l");
+    writeOut();
+#if defined(_WIN32)
+    SetConsoleMode(g_tty.in, g_tty.in_mode);
+    SetConsoleMode(g_tty.out, g_tty.out_mode);
+    SetConsoleOutputCP(g_tty.out_cp);
+#else
+    tcsetattr(STDIN_FILENO, TCSAFLUSH, &g_tty.saved);
+#endif
+}
+
+vec2i ttySize()
+{
+    vec2i size = terminalSize();
+    return vec2i(size.x / 2, size.y);
+}
+
+void ttyPresent(const RenderSnapshot& s)
+{
+    PROFILE_ZONE("ttyPresent");
+    Tty& t = g_tty;
+    vec2i size = terminalSize();
+    if (size.x != t.cols || size.y != t.rows)
+    {
+        // Unknown contents after a resize, clear and redraw everything.
+        t.cols = size.x;
+        t.rows = size.y;
+        TtyCell unknown;
+        unknown.glyph = 0;
+        t.front.assign((size_t)t.cols * t.rows, unknown);
+        emit("\x1b[0m\x1b[2J");
+        t.cursor_x = t.cursor_y = -1;
+        t.cur_fg = t.cur_bg = -1;
+    }
+
+    composeSnapshot(s, t.back, t.cols, t.rows);
+
+    u32 changed = 0;
+    for (int y = 0; y < t.rows; ++y)
+    {
+        for (int x = 0; x < t.cols; ++x)
+        {
+            int i = x + y * t.cols;
+            const TtyCell& c = t.back[i];
+            if (c == t.front[i]) continue;
+            moveCursor(x, y);
+            emitColors(c);
+            emitGlyph(c.glyph);
+            t.front[i] = c;
+            changed++;
+            // Without autowrap the cursor stays on the last column.
+            t.cursor_x = x + 1 < t.cols ? x + 1 : -1;
+        }
+    }
+
+    profileCounter("tty_bytes", (s64)t.out_buf.size());
+    profileCounter("tty_cells", (s64)changed);
+    writeOut();
+}
+
+void readInput()
+{
+#if defined(_WIN32)
+    // With virtual terminal input the console hands over the same sequences as a Unix tty.
+    DWORD events = 0;
+    while (GetNumberOfConsoleInputEvents(g_tty.in, &events) && events > 0)
+    {
+        INPUT_RECORD records[64];
+        DWORD count = 0;
+        if (!ReadConsoleInputA(g_tty.in, records, 64, &count)) break;
+        for (DWORD i = 0; i < count; ++i)
+        {
+            const KEY_EVENT_RECORD& k = records[i].Event.KeyEvent;
+            if (records[i].EventType != KEY_EVENT || !k.bKeyDown || k.uChar.AsciiChar == 0) continue;
+            for (int r = 0; r < scalar::max((int)k.wRepeatCount, 1); ++r)
+                g_tty.in_buf.push_back((u8)k.uChar.AsciiChar);
+        }
+    }
+#else
+    u8 buf[256];
+    pollfd fd{ STDIN_FILENO, POLLIN, 0 };
+    while (poll(&fd, 1, 0) > 0 && (fd.revents & POLLIN))
+    {
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) break;
+        g_tty.in_buf.insert(g_tty.in_buf.end(), buf, buf + n);
+    }
+#endif
+}
+
+void pressKey(InputFrame& f, int key)
+{
+    for (u16 k : f.keys)
+    {
+        if (k == key) return;
+    }
+    f.keys.push_back((u16)key);
+}
+
+// Parameters of a CSI sequence, "\x1b[1;2~" gives 1 and 2.
+int csiParams(const u8* p, int n, int* params, int max_params)
+{
+    int count = 0, value = 0;
+    bool any = false;
+    for (int i = 0; i < n; ++i)
+    {
+        if (p[i] >= '0' && p[i] <= '9')
+        {
+            value = value * 10 + (p[i] - '0');
+            any = true;
+        }
+        else if (p[i] == ';')
+        {
+            if (count < max_params) params[count++] = value;
+            value = 0;
+            any = false;
+        }
+    }
+    if (any && count < max_params) params[count++] = value;
+    return count;
+}
+
+// Keys that share a key with an unshifted character on a US layout.
+const char* const shifted_chars = "!@#$%^&*()_+{}|:\"<>?~";
+const char* const unshifted_chars = "1234567890-=[]\\;',./`";
+
+void pressChar(InputFrame& f, u8 c)
+{
+    if (c == '\r' || c == '\n') pressKey(f, KEY_ENTER);
+    else if (c == '\t') pressKey(f, KEY_TAB);
+    else if (c == 127 || c == 8) pressKey(f, KEY_BACKSPACE);
+    else if (c >= 'a' && c <= 'z') pressKey(f, KEY_A + (c - 'a'));
+    else if (c >= 'A' && c <= 'Z') pressKey(f, KEY_A + (c - 'A'));
+    else if (c < ' ' || c > '~') return;
+    else if (c == ' ' || strchr(unshifted_chars, c)) pressKey(f, c);
+    else if (const char* s = strchr(shifted_chars, c)) pressKey(f, unshifted_chars[s - shifted_chars]);
+}
+
+// Consumes one key or mouse sequence from the front of p. Returns 0 if the sequence is not
+// complete yet, -1 for Ctrl+C.
+int parseInput(const u8* p, int n, InputFrame& f)
+{
+    if (p[0] == 3) return -1;
+    if (p[0] != 0x1B)
+    {
+        pressChar(f, p[0]);
+        return 1;
+    }
+    if (n == 1) return 0;
+    if (p[1] == 'O')
+    {
+        if (n < 3) return 0;
+        switch (p[2])
+        {
+        case 'A': pressKey(f, KEY_UP); break;
+        case 'B': pressKey(f, KEY_DOWN); break;
+        case 'C': pressKey(f, KEY_RIGHT); break;
+        case 'D': pressKey(f, KEY_LEFT); break;
+        case 'P': case 'Q': case 'R': case 'S': pressKey(f, KEY_F1 + (p[2] - 'P')); break;
+        }
+        return 3;
+    }
+    if (p[1] != '[')
+    {
+        // Alt+key, the game has no use for the modifier.
+        pressKey(f, KEY_ESCAPE);
+        return 1;
+    }
+
+    int end = 2;
+    while (end < n && !(p[end] >= 0x40 && p[end] <= 0x7E && !(end == 2 && p[end] == '<'))) end++;
+    if (end >= n) return n > 32 ? n : 0;
+    u8 final = p[end];
+    int params[4] = { 0 };
+    int count = csiParams(p + 2, end - 2, params, 4);
+
+    if (p[2] == '<' && (final == 'M' || final == 'm') && count == 3)
+    {
+        // SGR mouse: button;column;row, M on press and m on release. The game wants pixels.
+        int button = params[0];
+        f.mouse_x = g_tty.mouse_x = (s16)((params[1] - 1) * 8);
+        f.mouse_y = g_tty.mouse_y = (s16)((params[2] - 1) * 16);
+        if (final == 'M')
+        {
+            if (button == 64) f.wheel = 1;
+            else if (button == 65) f.wheel = -1;
+            else if (button < 3) f.mouse_buttons |= 1 << (button == 0 ? MOUSE_BUTTON_LEFT : button == 1 ? MOUSE_BUTTON_MIDDLE : MOUSE_BUTTON_RIGHT);
+        }
+        return end + 1;
+    }
+
+    switch (final)
+    {
+    case 'A': pressKey(f, KEY_UP); break;
+    case 'B': pressKey(f, KEY_DOWN); break;
+    case 'C': pressKey(f, KEY_RIGHT); break;
+    case 'D': pressKey(f, KEY_LEFT); break;
+    case 'H': pressKey(f, KEY_HOME); break;
+    case 'F': pressKey(f, KEY_END); break;
+    case '~':
+    {
+        static const int function_keys[][2] = {
+            { 1, KEY_HOME }, { 2, KEY_INSERT }, { 3, KEY_DELETE }, { 4, KEY_END }, { 5, KEY_PAGE_UP }, { 6, KEY_PAGE_DOWN },
+            { 11, KEY_F1 }, { 12, KEY_F2 }, { 13, KEY_F3 }, { 14, KEY_F4 }, { 15, KEY_F5 }, { 17, KEY_F6 },
+            { 18, KEY_F7 }, { 19, KEY_F8 }, { 20, KEY_F9 }, { 21, KEY_F10 }, { 23, KEY_F11 }, { 24, KEY_F12 },
+        };
+        for (const auto& k : function_keys)
+        {
+            if (count > 0 && params[0] == k[0]) pressKey(f, k[1]);
+        }
+    } break;
+    }
+    return end + 1;
+}
+
+bool ttyPollInput(InputFrame& f)
+{
+    f.clearPresses();
+    f.mouse_x = g_tty.mouse_x;
+    f.mouse_y = g_tty.mouse_y;
+    if (!g_tty.open) return true;
+
+    readInput();
+    std::vector<u8>& in = g_tty.in_buf;
+    int pos = 0;
+    bool quit = false;
+    while (pos < (int)in.size())
+    {
+        int used = parseInput(in.data() + pos, (int)in.size() - pos, f);
+        if (used == 0)
+        {
+            // The rest of the sequence may still be in flight, give it one poll. An escape
+            // that is still alone after that was the key itself.
+            if (!g_tty.in_stalled)
+            {
+                g_tty.in_stalled = true;
+                break;
+            }
+            pressKey(f, KEY_ESCAPE);
+            used = 1;
+        }
+        g_tty.in_stalled = false;
+        if (used < 0)
+        {
+            quit = true;
+            used = 1;
+        }
+        pos += used;
+    }
+    in.erase(in.begin(), in.begin() + pos);
+    return !quit;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include "util/vector_math.h"
+
+struct InputFrame;
+struct RenderSnapshot;
+
+// Terminal backend for headless machines and SSH, selected with --tty. Draws the same render
+// snapshots as the window as UTF-8 text with 24-bit colour escapes, writing only the cells
+// that changed since the last frame, and reads keys and mouse clicks from raw mode stdin.
+
+// One terminal column, a TextBuffer cell covers two. Colours are 0xRRGGBB.
+struct TtyCell
+{
+    u32 glyph = ' ';
+    u32 fg = 0xFFFFFF;
+    u32 bg = 0;
+
+    bool operator==(const TtyCell& o) const { return glyph == o.glyph && fg == o.fg && bg == o.bg; }
+    bool operator!=(const TtyCell& o) const { return !(*this == o); }
+};
+
+// Switches the terminal to raw mode and the alternate screen. Fails if stdin or stdout is
+// not a terminal.
+bool ttyOpen();
+void ttyClose();
+
+// Terminal size in TextBuffer cells, two columns per cell.
+vec2i ttySize();
+
+// Fills f with the keys and clicks read since the last call. Returns false on Ctrl+C.
+bool ttyPollInput(InputFrame& f);
+
+// Draws s, only writing the cells that differ from what the terminal shows. The bytes and
+// cells written each frame go to the tty_bytes and tty_cells profiler counters.
+void ttyPresent(const RenderSnapshot& s);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "util/intern.h"
 #include "util/string.h"
 
 #include "vterm.h"
@@ -78,7 +79,7 @@ enum class ActorType
 struct TerrainInfo
 {
     Terrain terrain = Terrain::Invalid;
-    sstring name;
+    istring name;
 
     int character = '?';
     u32 color = 0;
@@ -87,26 +88,26 @@ struct TerrainInfo
     bool passable = true;
 
     TerrainInfo() {}
-    TerrainInfo(Terrain terrain, const sstring& name, int character, u32 color, u32 bg_color, bool passable)
+    TerrainInfo(Terrain terrain, istring name, int character, u32 color, u32 bg_color, bool passable)
         : terrain(terrain), name(name), character(character), color(color), bg_color(bg_color), passable(passable) {}
 };
 
 struct ItemTypeInfo
 {
     ItemType type = ItemType::Invalid;
-    sstring name;
+    istring name;
 
     int character = '?';
     u32 color = 0xFFFF00FF;
 
     ItemTypeInfo() {}
-    ItemTypeInfo(ItemType t, const sstring& n, int ch, u32 col) : type(t), name(n), character(ch), color(col) {}
+    ItemTypeInfo(ItemType t, istring n, int ch, u32 col) : type(t), name(n), character(ch), color(col) {}
 };
 
 struct ActorInfo
 {
     ActorType actor = ActorType::Invalid;
-    sstring name;
+    istring name;
 
     int character = '?';
     u32 color = 0xFFFF00FF;
@@ -117,7 +118,7 @@ struct ActorInfo
     int max_health = 10;
 
     ActorInfo() {}
-    ActorInfo(ActorType actor, const sstring& name, int character, u32 color, int priority, bool on_ground, int health)
+    ActorInfo(ActorType actor, istring name, int character, u32 color, int priority, bool on_ground, int health)
         : actor(actor), name(name), character(character), color(color), priority(priority), is_ground(on_ground), max_health(health) {}
 };
 
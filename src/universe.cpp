@@ -1,5 +1,7 @@
 #include "universe.h"
 
+#include <algorithm>
+#include <bit>
 #include <vector>
 
 #include "actor.h"
@@ -8,6 +10,7 @@
 #include "ship.h"
 #include "sound.h"
 #include "procgen.h"
+#include "profiler.h"
 
 const char* UActorTypeNames[UActorTypeCount]
 {
@@ -39,6 +42,19 @@ SpawningPct spawning_bands[5]
     { 0.0f, 0.05f, 0.15f, 0.8f, 0.95f, 1.0f },
 };
 
+// Simulation detail by distance from the player. Inside their scanners plus a margin for
+// anything that could reach them in a few ticks actors get the full update, further out
+// ships keep moving but only think every few ticks, and past LodCoarseRange they are
+// frozen and only drift along their velocity until they come back within LodThawMargin of
+// the range or are unloaded past LodUnloadRange. The margin keeps a ship skirting the edge
+// from being unplaced and placed every tick.
+constexpr float LodMinScannerRange = 35.0f;
+constexpr float LodFullMargin = 30.0f;
+constexpr float LodCoarseRange = 110.0f;
+constexpr float LodThawMargin = 10.0f;
+constexpr float LodUnloadRange = 160.0f;
+constexpr int LodCoarseInterval = 4;
+
 bool isShipType(UActorType t)
 {
     return t == UActorType::CargoShip || t == UActorType::Player || t == UActorType::Torpedo || t == UActorType::PirateShip;
@@ -57,6 +73,12 @@ UShip::~UShip()
     ship = nullptr;
 }
 
+void UShip::adoptShip(Ship* s)
+{
+    ship = s;
+    g_game.ships.push_back(ship);
+}
+
 void UShip::update(pcg32& rng)
 {
     UActor::update(rng);
@@ -68,81 +90,102 @@ void UShip::update(pcg32& rng)
 
         bool pdc_used[16]{ false };
 
-        for (UTorpedo* t : g_game.universe->torpedoes)
+        for (UTorpedo* t = g_game.universe->incomingTorpedoes(id); t; t = t->next_incoming)
         {
-            if (t->target == id)
+            if ((pos() - t->pos()).length() > 35)
             {
-                if ((pos - t->pos).length() > 35)
+                continue;
+            }
+            bool has_pdc = false;
+            int i = 0;
+            for (PDC* p : ship->pdcs)
+            {
+                i++;
+                if (p->status != ShipObject::Status::Active) continue;
+                if (p->rounds == 0) continue;
+                if (pdc_used[i]) continue;
+
+                if (this == g_game.uplayer)
                 {
-                    continue;
+                    playSound(SoundEffect::PDCFire);
                 }
-                bool has_pdc = false;
-                int i = 0;
-                for (PDC* p : ship->pdcs)
-                {
-                    i++;
-                    if (p->status != ShipObject::Status::Active) continue;
-                    if (p->rounds == 0) continue;
-                    if (pdc_used[i]) continue;
 
-                    if (this == g_game.uplayer)
-                    {
-                        playSound(SoundEffect::PDCFire);
-                    }
-
-                    std::vector<UTorpedo*> intermediates;
-                    auto points = findRay(pos, t->pos);
-                    bool blocked = false;
-                    for (vec2i p : points)
+                frame_vector<UTorpedo*> intermediates;
+                auto points = findRay(pos(), t->pos());
+                bool blocked = false;
+                for (vec2i p : points)
+                {
+                    auto it = g_game.universe->actors.find(p);
+                    if (it.found)
                     {
-                        auto it = g_game.universe->actors.find(p);
-                        if (it.found)
+                        if (it.value->type == UActorType::Torpedo)
                         {
-                            if (it.value->type == UActorType::Torpedo)
-                            {
-                                intermediates.push_back((UTorpedo*)it.value);
-                            }
-                            else
-                            {
-                                blocked = true;
-                                break;
-                            }
+                            intermediates.push_back((UTorpedo*)it.value);
+                        }
+                        else
+                        {
+                            blocked = true;
+                            break;
                         }
                     }
-                    if (blocked) continue;
-                    u32 col = 0xFFFFFFFF;
-                    if (type == UActorType::PirateShip) col = 0xFFFF0000;
-                    else if (type == UActorType::CargoShip) col = 0xFF0000FF;
-                    RailgunAnimation* anim = new RailgunAnimation(0xFFFFFFFF, getProjectileCharacter(getDirection(pos, t->pos + t->vel)));
-                    for (vec2i p : points) anim->points.push_back(p);
-                    pdc_used[i] = true;
-                    p->rounds = scalar::max(0, p->rounds - g_game.rng.nextInt(25, 75));
-                    has_pdc = true;
-                    for (UTorpedo* torp : intermediates)
+                }
+                if (blocked) continue;
+                u32 col = 0xFFFFFFFF;
+                if (type == UActorType::PirateShip) col = 0xFFFF0000;
+                else if (type == UActorType::CargoShip) col = 0xFF0000FF;
+                int anim = g_game.uanimations.railgun(0xFFFFFFFF, getProjectileCharacter(getDirection(pos(), t->pos() + t->vel())));
+                if (anim >= 0)
+                    for (vec2i p : points) g_game.uanimations.addPoint(anim, p);
+                pdc_used[i] = true;
+                p->rounds = scalar::max(0, p->rounds - g_game.rng.nextInt(25, 75));
+                has_pdc = true;
+                for (UTorpedo* torp : intermediates)
+                {
+                    float distance = (torp->pos() - pos()).length();
+                    float hit_chance = 1 / (p->firing_variance * distance);
+                    if (g_game.rng.nextFloat() < hit_chance)
                     {
-                        float distance = (torp->pos - pos).length();
-                        float hit_chance = 1 / (p->firing_variance * distance);
-                        if (g_game.rng.nextFloat() < hit_chance)
+                        g_game.uanimations.addHit(anim, torp->pos());
+                        torp->dead = true;
+                        if (this == g_game.uplayer)
                         {
-                            anim->hits.push_back(torp->pos);
-                            torp->dead = true;
-                            if (this == g_game.uplayer)
-                            {
-                                if (torp->target == g_game.uplayer->id) g_game.log.log("Incoming torpedo destroyted by point defences.");
-                                else g_game.log.log("Collateral torpedo destroyted by point defences.");
-                            }
-                            else if (torp->source == g_game.uplayer->id) g_game.log.log("Torpedo destroyed by enemy point defences.");
-                            break;
+                            if (torp->target == g_game.uplayer->id) g_game.log.log("Incoming torpedo destroyted by point defences.");
+                            else g_game.log.log("Collateral torpedo destroyted by point defences.");
                         }
-                        else
-                            anim->misses.push_back(torp->pos);
+                        else if (torp->source == g_game.uplayer->id) g_game.log.log("Torpedo destroyed by enemy point defences.");
+                        break;
                     }
-                    if (g_game.show_universe)
-                        g_game.uanimations.push_back(anim);
                     else
-                        delete anim;
+                        g_game.uanimations.addMiss(anim, torp->pos());
                 }
-                if (!has_pdc) break;
+            }
+            if (!has_pdc) break;
+        }
+    }
+}
+
+void UShip::coarseUpdate(pcg32& rng, int ticks)
+{
+    // No point defence out here, nothing the player sees depends on it.
+    if (ship && ship->hull_integrity <= 0)
+        dead = true;
+}
+
+void UShip::wander(pcg32& rng)
+{
+    if (vel().length() < 2)
+    {
+        vel() += vec2i(rng.nextInt(-1, 2), rng.nextInt(-1, 2));
+    }
+    float speed = vel().length();
+    if (speed > 0)
+    {
+        for (int i = 1; i <= 3; ++i)
+        {
+            if (g_game.universe->hasActor(pos() + vel() * i))
+            {
+                vel() = vec2i((int)round(vel().x / speed), (int)round(vel().y / speed));
+                break;
             }
         }
     }
@@ -174,16 +217,20 @@ bool UShip::fireTorpedo(vec2i target, int power)
             return false;
         }
 
-        vec2i offs = direction(getDirection(pos, target));
+        vec2i offs = direction(getDirection(pos(), target));
         if (offs.zero()) offs = vec2i(1, 0);
-        vec2i spawn_pos = pos - vel + offs * 2;
+        vec2i spawn_pos = pos() - vel() + offs * 2;
 
         UTorpedo* torp = new UTorpedo(spawn_pos, power);
         torp->source = id;
         torp->target = isShipType(t.value->type) ? t.value->id : 0;
         torp->target_pos = target;
-        torp->vel = vel;
-        g_game.universe->spawn(torp);
+        torp->vel() = vel();
+        if (!g_game.universe->spawn(torp))
+        {
+            delete torp;
+            return false;
+        }
         if (this == g_game.uplayer)
         {
             g_game.log.log("Torpedo launched.");
@@ -227,15 +274,15 @@ bool UShip::fireRailgun(vec2i target, int power)
     pcg32& rng = g_game.universe->rng;
     float firing_variance = weapon->firing_variance;
     bool hit_anything = false;
-    std::vector<vec2i> steps = findRay(pos, pos + (target - pos) * int(100 / (target - pos).length()));
-    RailgunAnimation* anim = new RailgunAnimation(0xFFFFFFFF, getProjectileCharacter(getDirection(pos, target)));
+    frame_vector<vec2i> steps = findRay(pos(), pos() + (target - pos()) * int(100 / (target - pos()).length()));
+    int anim = g_game.uanimations.railgun(0xFFFFFFFF, getProjectileCharacter(getDirection(pos(), target)));
     for (vec2i s: steps)
     {
-        anim->points.push_back(s);
+        g_game.uanimations.addPoint(anim, s);
         auto it = g_game.universe->actors.find(s);
         if (it.found)
         {
-            float distance = (pos - s).length();
+            float distance = (pos() - s).length();
             float hit_chance = 1 / (firing_variance * distance);
             bool solid_target = false;
             switch (it.value->type)
@@ -246,7 +293,7 @@ bool UShip::fireRailgun(vec2i target, int power)
                 {
                     g_game.log.logf("Railgun impact (%.0f%%).", hit_chance * 100);
                     solid_target = true;
-                    anim->hits.push_back(s);
+                    g_game.uanimations.addHit(anim, s);
                     ((UShip*)it.value)->ship->railgun(vec2i(), power);
                     g_game.gameover_reason = "Railgun fire";
                     playSound(SoundEffect::RailgunImpact);
@@ -254,13 +301,13 @@ bool UShip::fireRailgun(vec2i target, int power)
                 else
                 {
                     g_game.log.logf("Railgun near miss (%.0f%%).", hit_chance * 100);
-                    anim->misses.push_back(s);
+                    g_game.uanimations.addMiss(anim, s);
                 }
                 hit_anything = true;
             } break;
             case UActorType::Asteroid:
             {
-                anim->misses.push_back(s);
+                g_game.uanimations.addMiss(anim, s);
                 solid_target = true;
             } break;
             case UActorType::CargoShip:
@@ -270,7 +317,7 @@ bool UShip::fireRailgun(vec2i target, int power)
                 {
                     if (this == g_game.uplayer) g_game.log.logf("Target hit (%.0f%%).", hit_chance * 100);
                     solid_target = true;
-                    anim->hits.push_back(s);
+                    g_game.uanimations.addHit(anim, s);
                     ((UShip*) it.value)->ship->railgun(vec2i(), power);
                     if (this == g_game.uplayer && ((UShip*)it.value)->ship->hull_integrity <= 0)
                         g_game.uplayer->ships_killed++;
@@ -278,7 +325,7 @@ bool UShip::fireRailgun(vec2i target, int power)
                 else
                 {
                     if (this == g_game.uplayer) g_game.log.logf("Target missed (%.0f%%).", hit_chance * 100);
-                    anim->misses.push_back(s);
+                    g_game.uanimations.addMiss(anim, s);
                 }
                 hit_anything = true;
             } break;
@@ -287,12 +334,12 @@ bool UShip::fireRailgun(vec2i target, int power)
                 if (rng.nextFloat() < hit_chance * 0.25f)
                 {
                     if (this == g_game.uplayer) g_game.log.logf("Torpedo shot down (%.0f%%).", hit_chance * 25);
-                    anim->hits.push_back(s);
+                    g_game.uanimations.addHit(anim, s);
                 }
                 else
                 {
                     if (this == g_game.uplayer) g_game.log.logf("Torpedo missed (%.0f%%).", hit_chance * 25);
-                    anim->misses.push_back(s);
+                    g_game.uanimations.addMiss(anim, s);
                 }
                 hit_anything = true;
             } break;
@@ -304,18 +351,17 @@ bool UShip::fireRailgun(vec2i target, int power)
     if (!hit_anything && this == g_game.uplayer)
         g_game.log.log("Target missed.");
 
-    if (g_game.show_universe)
-        g_game.uanimations.push_back(anim);
-    else
-        delete anim;
     return true;
 }
 
 UCargoShip::UCargoShip(vec2i p)
     : UShip(UActorType::CargoShip, p)
 {
-    ship = generate("cargo", "cargo_ship");
-    g_game.ships.push_back(ship);
+}
+
+void UCargoShip::adoptShip(Ship* s)
+{
+    UShip::adoptShip(s);
 
     for (Actor* a : ship->map->actors)
     {
@@ -340,31 +386,22 @@ UCargoShip::UCargoShip(vec2i p)
 void UCargoShip::update(pcg32& rng)
 {
     UShip::update(rng);
-    if (vel.length() < 2)
-    {
-        vel += vec2i(rng.nextInt(-1, 2), rng.nextInt(-1, 2));
-    }
-    float speed = vel.length();
-    if (speed > 0)
-    {
-        for (int i = 1; i <= 3; ++i)
-        {
-            if (g_game.universe->hasActor(pos + vel * i))
-            {
-                vel = vec2i((int)round(vel.x / speed), (int)round(vel.y / speed));
-                break;
-            }
-        }
-    }
+    wander(rng);
+}
+
+void UCargoShip::coarseUpdate(pcg32& rng, int ticks)
+{
+    UShip::coarseUpdate(rng, ticks);
+    wander(rng);
 }
 
 void UCargoShip::render(TextBuffer& buffer, vec2i origin)
 {
     if (animating) return;
-    buffer.setTile(pos - origin, 'C', 0xFFFFFFFF, LayerPriority_Actors);
-    if (!vel.zero())
+    buffer.setTile(pos() - origin, 'C', 0xFFFFFFFF, LayerPriority_Actors);
+    if (!vel().zero())
     {
-        buffer.setOverlay((pos + vel) - origin, 0x800000FF, LayerPriority_Overlay);
+        buffer.setOverlay((pos() + vel()) - origin, 0x800000FF, LayerPriority_Overlay);
     }
 }
 
@@ -372,7 +409,24 @@ UPirateShip::UPirateShip(vec2i p, int c, u32 col)
     : UShip(UActorType::PirateShip, p)
     , character(c), color(col)
 {
-    ship = generate("pirate", "pirate_ship");
+    if (character == 'A')
+    {
+        torp_max_reloads = 100;
+        railgun_max_reloads = 100;
+        railgun_power = 3;
+        torpedo_power = 16;
+    }
+    else if (character == 'M')
+    {
+        railgun_power = 2;
+        torpedo_power = 8;
+    }
+}
+
+void UPirateShip::adoptShip(Ship* s)
+{
+    UShip::adoptShip(s);
+
     for (Actor* a: ship->map->actors)
     {
         switch (a->type)
@@ -397,26 +451,6 @@ UPirateShip::UPirateShip(vec2i p, int c, u32 col)
         default: break;
         }
     }
-    g_game.ships.push_back(ship);
-    if (character == 'A')
-    {
-        torp_max_reloads = 100;
-        railgun_max_reloads = 100;
-        railgun_power = 3;
-        torpedo_power = 16;
-        for (Actor* a : ship->map->actors)
-        {
-            if (a->type == ActorType::Reactor)
-            {
-                ((Reactor*)a)->capacity = 100000;
-            }
-        }
-    }
-    else if (character == 'M')
-    {
-        railgun_power = 2;
-        torpedo_power = 8;
-    }
 }
 
 bool UPirateShip::isTarget(UActor* actor)
@@ -454,12 +488,12 @@ void UPirateShip::update(pcg32& rng)
             {
                 if (isTarget(it.value))
                 {
-                    float dist = (pos - it.value->pos).length();
-                    if (dist < closest_distance && dist < sensor_range && g_game.universe->isVisible(pos, it.value->pos))
+                    float dist = (pos() - it.value->pos()).length();
+                    if (dist < closest_distance && dist < sensor_range && g_game.universe->isVisible(pos(), it.value->pos()))
                     {
                         closest_distance = dist;
                         target = it.value->id;
-                        target_last_pos = it.value->pos;
+                        target_last_pos = it.value->pos();
                     }
                 }
             }
@@ -489,18 +523,18 @@ void UPirateShip::update(pcg32& rng)
             }
             else
             {
-                float dist = (pos - s->pos).length();
-                if (dist < sensor_range && g_game.universe->isVisible(pos, s->pos))
+                float dist = (pos() - s->pos()).length();
+                if (dist < sensor_range && g_game.universe->isVisible(pos(), s->pos()))
                 {
                     // If the target is visible and within sensor range, update its last known position and potentially fire upon it
-                    target_last_pos = s->pos;
+                    target_last_pos = s->pos();
                     if (dist < 12 && rng.nextFloat() < 0.6f)
                     {
-                        fireRailgun(s->pos, railgun_power);
+                        fireRailgun(s->pos(), railgun_power);
                     }
                     else if (dist < 25 && rng.nextFloat() < 0.3f)
                     {
-                        fireTorpedo(s->pos, torpedo_power);
+                        fireTorpedo(s->pos(), torpedo_power);
                     }
                 }
                 else
@@ -512,66 +546,85 @@ void UPirateShip::update(pcg32& rng)
         }
     }
 
-    if (target == 0)
+    steer(rng);
+    reloadWeapons(1);
+}
+
+void UPirateShip::coarseUpdate(pcg32& rng, int ticks)
+{
+    UShip::coarseUpdate(rng, ticks);
+
+    // No target scans or weapons, keep chasing a target that is still in range and
+    // otherwise wander until the full update takes over again.
+    float sensor_range = ship->scannerRange();
+    if (target != 0)
     {
-        // If no target, wander around
-        if (vel.length() < 2)
-        {
-            vel += vec2i(rng.nextInt(-1, 2), rng.nextInt(-1, 2));
-        }
-        float speed = vel.length();
-        if (speed > 0)
+        auto target_it = g_game.universe->actor_ids.find(target);
+        if (!target_it.found || !isTarget(target_it.value) || (target_it.value->pos() - pos()).length() >= sensor_range)
         {
-            for (int i = 1; i <= 3; ++i)
-            {
-                if (g_game.universe->hasActor(pos + vel * i))
-                {
-                    vel = vec2i((int)round(vel.x / speed), (int)round(vel.y / speed));
-                    break;
-                }
-            }
+            target = 0;
+            check_for_target = 5;
         }
     }
     else
+    {
+        check_for_target = scalar::max(0, check_for_target - ticks);
+    }
+
+    steer(rng);
+    reloadWeapons(ticks);
+}
+
+void UPirateShip::steer(pcg32& rng)
+{
+    if (target == 0)
+    {
+        // If no target, wander around
+        wander(rng);
+    }
+    else
     {
         auto target_it = g_game.universe->actor_ids.find(target);
         debug_assert(target_it.found);
         UShip* s = (UShip*)target_it.value;
 
-        float speed = vel.length();
-        vec2i dist = target_last_pos - pos;
+        float speed = vel().length();
+        vec2i dist = target_last_pos - pos();
         if (dist.length() > 8)
         {
             // If we're far from the target, move towards it
-            vec2i rvel = vel - s->vel;
+            vec2i rvel = vel() - s->vel();
 
             int slowdown_x = (abs(rvel.x) * (abs(rvel.x) + 1)) / 2;
             if ((rvel.x < 0) != (dist.x < 0))
-                vel.x += (dist.x < 0) ? -1 : 1;
+                vel().x += (dist.x < 0) ? -1 : 1;
             else if (dist.y != 0 && abs(dist.x) <= slowdown_x)
-                vel.x += (vel.x < 0) ? 1 : -1;
+                vel().x += (vel().x < 0) ? 1 : -1;
             else if (abs(dist.x) > slowdown_x)
-                vel.x += (vel.x < 0) ? -1 : 1;
+                vel().x += (vel().x < 0) ? -1 : 1;
 
             int slowdown_y = (abs(rvel.y) * (abs(rvel.y) + 1)) / 2;
-            if ((vel.y < 0) != (dist.y < 0))
-                vel.y += (dist.y < 0) ? -1 : 1;
+            if ((vel().y < 0) != (dist.y < 0))
+                vel().y += (dist.y < 0) ? -1 : 1;
             else if (dist.x != 0 && abs(dist.y) <= slowdown_y)
-                vel.y += (vel.y < 0) ? 1 : -1;
+                vel().y += (vel().y < 0) ? 1 : -1;
             else if (abs(dist.y) > slowdown_y)
-                vel.y += (vel.y < 0) ? -1 : 1;
+                vel().y += (vel().y < 0) ? -1 : 1;
         }
         else
         {
             // Slowdown
-            if (vel.x < 0) vel.x++;
-            else if (vel.x > 0) vel.x--;
+            if (vel().x < 0) vel().x++;
+            else if (vel().x > 0) vel().x--;
 
-            if (vel.y < 0) vel.y++;
-            else if (vel.y > 0) vel.y--;
+            if (vel().y < 0) vel().y++;
+            else if (vel().y > 0) vel().y--;
         }
     }
+}
 
+void UPirateShip::reloadWeapons(int ticks)
+{
     if (torp_max_reloads > 0)
     {
         TorpedoLauncher* needs_reload = nullptr;
@@ -585,7 +638,7 @@ void UPirateShip::update(pcg32& rng)
         }
         if (needs_reload)
         {
-            torp_reload_cooldown--;
+            torp_reload_cooldown -= ticks;
             if (torp_reload_cooldown <= 0)
             {
                 torp_reload_cooldown = 10;
@@ -607,7 +660,7 @@ void UPirateShip::update(pcg32& rng)
         }
         if (needs_reload)
         {
-            railgun_reload_cooldown--;
+            railgun_reload_cooldown -= ticks;
             if (railgun_reload_cooldown <= 0)
             {
                 railgun_reload_cooldown = 10;
@@ -621,22 +674,22 @@ void UPirateShip::update(pcg32& rng)
 void UPirateShip::render(TextBuffer& buffer, vec2i origin)
 {
     if (animating) return;
-    buffer.setTile(pos - origin, character, color, LayerPriority_Actors);
-    if (!vel.zero())
+    buffer.setTile(pos() - origin, character, color, LayerPriority_Actors);
+    if (!vel().zero())
     {
-        buffer.setOverlay((pos + vel) - origin, 0x80FF8080, LayerPriority_Overlay);
+        buffer.setOverlay((pos() + vel()) - origin, 0x80FF8080, LayerPriority_Overlay);
     }
 }
 
 void UPlayer::update(pcg32& rng)
 {
     UShip::update(rng);
-    float speed = vel.length();
+    float speed = vel().length();
     if (speed > 0)
     {
         for (int i = 1; i <= 2; ++i)
         {
-            if (g_game.universe->hasActor(pos + vel * i))
+            if (g_game.universe->hasActor(pos() + vel() * i))
             {
                 g_game.log.log("Proximity alert");
                 break;
@@ -648,10 +701,10 @@ void UPlayer::update(pcg32& rng)
 void UPlayer::render(TextBuffer& buffer, vec2i origin)
 {
     if (animating) return;
-    buffer.setTile(pos - origin, '@', 0xFFFFFFFF, LayerPriority_Actors);
-    if (!vel.zero())
+    buffer.setTile(pos() - origin, '@', 0xFFFFFFFF, LayerPriority_Actors);
+    if (!vel().zero())
     {
-        buffer.setOverlay((pos + vel) - origin, 0x8000FF00, LayerPriority_Overlay);
+        buffer.setOverlay((pos() + vel()) - origin, 0x8000FF00, LayerPriority_Overlay);
     }
 }
 
@@ -659,41 +712,66 @@ void UTorpedo::update(pcg32& rng)
 {
     UShip::update(rng);
     vec2i tvel;
-    if (target != 0)
+    if (!trackTarget(tvel)) return;
+    steer(target_pos - pos(), tvel);
+}
+
+void UTorpedo::coarseUpdate(pcg32& rng, int ticks)
+{
+    UShip::coarseUpdate(rng, ticks);
+    vec2i tvel;
+    if (!trackTarget(tvel)) return;
+
+    // Catch up on the steps the skipped ticks would have taken, following where both ends
+    // of the chase would be so it still brakes in time.
+    vec2i p = pos();
+    vec2i tp = target_pos;
+    for (int i = 0; i < ticks; ++i)
     {
-        auto it = g_game.universe->actor_ids.find(target);
-        if (!it.found)
-        {
-            if (source == g_game.uplayer->id)
-                g_game.log.log("Torpedo has self-destructed as it's target was lost.");
-            dead = true;
-            return;
-        }
-        debug_assert(isShipType(it.value->type));
-        UShip* target = (UShip*)it.value;
-        tvel = target->vel;
-        target_pos = target->pos + target->vel;
+        steer(tp - p, tvel);
+        p += vel();
+        tp += tvel;
+    }
+}
+
+bool UTorpedo::trackTarget(vec2i& tvel)
+{
+    if (target == 0) return true;
+    auto it = g_game.universe->actor_ids.find(target);
+    if (!it.found)
+    {
+        if (source == g_game.uplayer->id)
+            g_game.log.log("Torpedo has self-destructed as it's target was lost.");
+        g_game.universe->retarget(this, 0);
+        dead = true;
+        return false;
     }
-    float speed = vel.length();
-    vec2i dist = target_pos - pos;
+    debug_assert(isShipType(it.value->type));
+    UShip* target = (UShip*)it.value;
+    tvel = target->vel();
+    target_pos = target->pos() + target->vel();
+    return true;
+}
 
-    vec2i rvel = vel - tvel;
+void UTorpedo::steer(vec2i dist, vec2i tvel)
+{
+    vec2i rvel = vel() - tvel;
 
     int slowdown_x = (abs(rvel.x) * (abs(rvel.x) + 1)) / 2;
     if ((rvel.x < 0) != (dist.x < 0))
-        vel.x += (dist.x < 0) ? -1 : 1;
+        vel().x += (dist.x < 0) ? -1 : 1;
     else if (dist.y != 0 && abs(dist.x) <= slowdown_x)
-        vel.x += (vel.x < 0) ? 1 : -1;
+        vel().x += (vel().x < 0) ? 1 : -1;
     else if (abs(dist.x) > slowdown_x)
-        vel.x += (vel.x < 0) ? -1 : 1;
+        vel().x += (vel().x < 0) ? -1 : 1;
 
     int slowdown_y = (abs(rvel.y) * (abs(rvel.y) + 1)) / 2;
-    if ((vel.y < 0) != (dist.y < 0))
-        vel.y += (dist.y < 0) ? -1 : 1;
+    if ((vel().y < 0) != (dist.y < 0))
+        vel().y += (dist.y < 0) ? -1 : 1;
     else if (dist.x != 0 && abs(dist.y) <= slowdown_y)
-        vel.y += (vel.y < 0) ? 1 : -1;
+        vel().y += (vel().y < 0) ? 1 : -1;
     else if (abs(dist.y) > slowdown_y)
-        vel.y += (vel.y < 0) ? -1 : 1;
+        vel().y += (vel().y < 0) ? -1 : 1;
 }
 
 void UTorpedo::render(TextBuffer& buffer, vec2i origin)
@@ -704,10 +782,10 @@ void UTorpedo::render(TextBuffer& buffer, vec2i origin)
         col = 0xFFFF0000;
     else if (source == g_game.uplayer->id)
         col = 0xFF00FF00;
-    buffer.setTile(pos - origin, '!', col, LayerPriority_Actors);
-    if (!vel.zero())
+    buffer.setTile(pos() - origin, '!', col, LayerPriority_Actors);
+    if (!vel().zero())
     {
-        buffer.setOverlay((pos + vel) - origin, 0x80FFFF00, LayerPriority_Overlay);
+        buffer.setOverlay((pos() + vel()) - origin, 0x80FFFF00, LayerPriority_Overlay);
     }
 }
 
@@ -717,9 +795,9 @@ void UAsteroid::render(TextBuffer& buffer, vec2i origin)
     for (float a = 0; a + step/2 < scalar::PIf * 2; a += step)
     {
         float r = (radius + (float) cos(a * 1.2 + sfreq) * radius);
-        vec2i p = pos + vec2i((int) round(cos(a) * r), (int) round(sin(a) * r));
+        vec2i p = pos() + vec2i((int) round(cos(a) * r), (int) round(sin(a) * r));
         for (int r0 = 0; r0 < r; ++r0)
-            buffer.setTile(pos + vec2i((int)round(cos(a) * r0), (int)round(sin(a) * r0)) - origin, '0', inner_color, LayerPriority_Background-1);
+            buffer.setTile(pos() + vec2i((int)round(cos(a) * r0), (int)round(sin(a) * r0)) - origin, '0', inner_color, LayerPriority_Background-1);
         buffer.setTile(p - origin, getProjectileCharacter(rotate90(getDirection(a))), color, LayerPriority_Background);
     }
 }
@@ -739,9 +817,9 @@ void UStation::update(pcg32& rng)
 
 void UStation::render(TextBuffer& buffer, vec2i origin)
 {
-    buffer.setTile(pos - origin, 'S', 0xFFFFFFFF, LayerPriority_Actors);
-    buffer.setText((pos - origin - vec2i(1, 0)) * vec2i(2, 1) + vec2i(1, 0), Border_TeeRight, 0xFFFFFFFF, LayerPriority_Actors - 1);
-    buffer.setText((pos - origin + vec2i(1, 0)) * vec2i(2, 1), Border_TeeLeft, 0xFFFFFFFF, LayerPriority_Actors - 1);
+    buffer.setTile(pos() - origin, 'S', 0xFFFFFFFF, LayerPriority_Actors);
+    buffer.setText((pos() - origin - vec2i(1, 0)) * vec2i(2, 1) + vec2i(1, 0), Border_TeeRight, 0xFFFFFFFF, LayerPriority_Actors - 1);
+    buffer.setText((pos() - origin + vec2i(1, 0)) * vec2i(2, 1), Border_TeeLeft, 0xFFFFFFFF, LayerPriority_Actors - 1);
 }
 
 UShipWreck::UShipWreck(vec2i p)
@@ -757,7 +835,7 @@ void UShipWreck::update(pcg32& rng)
 
 void UShipWreck::render(TextBuffer& buffer, vec2i origin)
 {
-    buffer.setTile(pos - origin, '$', 0xFFFFFFFF, LayerPriority_Actors);
+    buffer.setTile(pos() - origin, '$', 0xFFFFFFFF, LayerPriority_Actors);
 }
 
 UMilitaryStation::UMilitaryStation(vec2i p)
@@ -769,22 +847,22 @@ void UMilitaryStation::update(pcg32& rng)
 {
     UActor::update(rng);
     if (!g_game.universe) return;
-    float dist = (g_game.uplayer->pos - pos).length();
+    float dist = (g_game.uplayer->pos() - pos()).length();
     if (dist < 35 && !g_game.uplayer->ship->transponder_masked)
     {
         charge_time--;
         if (charge_time <= 0)
         {
-            vec2i offs = direction(getDirection(pos, g_game.uplayer->pos));
+            vec2i offs = direction(getDirection(pos(), g_game.uplayer->pos()));
             if (offs.zero()) offs = vec2i(1, 0);
-            vec2i spawn_pos = pos + offs * 2;
+            vec2i spawn_pos = pos() + offs * 2;
 
             UTorpedo* torp = new UTorpedo(spawn_pos, 12);
             torp->source = id;
             torp->target = g_game.uplayer->id;
-            torp->target_pos = g_game.uplayer->pos;
-            torp->vel = vec2i(0, 0);
-            g_game.universe->spawn(torp);
+            torp->target_pos = g_game.uplayer->pos();
+            torp->vel() = vec2i(0, 0);
+            if (!g_game.universe->spawn(torp)) delete torp;
             charge_time = 5;
         }
     }
@@ -792,48 +870,166 @@ void UMilitaryStation::update(pcg32& rng)
 
 void UMilitaryStation::render(TextBuffer& buffer, vec2i origin)
 {
-    buffer.setTile(pos - origin, 'M', 0xFFFF5000, LayerPriority_Actors);
-    buffer.setText((pos - origin - vec2i(1, 0)) * vec2i(2, 1) + vec2i(1, 0), Border_TeeRight, 0xFFFF5000, LayerPriority_Actors - 1);
-    buffer.setText((pos - origin + vec2i(1, 0)) * vec2i(2, 1), Border_TeeLeft, 0xFFFF5000, LayerPriority_Actors - 1);
+    buffer.setTile(pos() - origin, 'M', 0xFFFF5000, LayerPriority_Actors);
+    buffer.setText((pos() - origin - vec2i(1, 0)) * vec2i(2, 1) + vec2i(1, 0), Border_TeeRight, 0xFFFF5000, LayerPriority_Actors - 1);
+    buffer.setText((pos() - origin + vec2i(1, 0)) * vec2i(2, 1), Border_TeeLeft, 0xFFFF5000, LayerPriority_Actors - 1);
 }
 
-vec2i getOffset(int& i, int& x, int& y)
+Universe::Universe()
 {
-    y++;
-    if (y > i)
+}
+
+Universe::~Universe()
+{
+    for (auto it : actor_ids)
     {
-        y = -i;
-        x++;
+        delete it.value;
     }
-    while (true)
+}
+
+void OccupancyGrid::reset(vec2i center)
+{
+    min = center - vec2i(Size / 2, Size / 2);
+    bits.assign(Size * Words, 0);
+}
+
+bool OccupancyGrid::contains(vec2i p) const
+{
+    return !bits.empty() && (u32)(p.x - min.x) < (u32)Size && (u32)(p.y - min.y) < (u32)Size;
+}
+
+bool OccupancyGrid::test(vec2i p) const
+{
+    int x = p.x - min.x;
+    return (bits[(p.y - min.y) * Words + (x >> 6)] >> (x & 63)) & 1;
+}
+
+void OccupancyGrid::set(vec2i p, bool taken)
+{
+    if (!contains(p)) return;
+    int x = p.x - min.x;
+    u64& word = bits[(p.y - min.y) * Words + (x >> 6)];
+    u64 bit = 1ull << (x & 63);
+    word = taken ? (word | bit) : (word & ~bit);
+}
+
+bool OccupancyGrid::firstFree(int y, int x0, int x1, int& x) const
+{
+    const u64* row = &bits[(y - min.y) * Words];
+    int b0 = x0 - min.x, b1 = x1 - min.x;
+    for (int w = b0 >> 6; w <= b1 >> 6; ++w)
     {
-        for (; x <= i; x++)
+        u64 free = ~row[w];
+        if (w == b0 >> 6) free &= ~0ull << (b0 & 63);
+        if (w == b1 >> 6) free &= ~0ull >> (63 - (b1 & 63));
+        if (free)
         {
-            for (; y <= i; y++)
-            {
-                if (abs(x) == i || abs(y) == i)
-                    return vec2i(x, y);
-            }
-            y = -i;
+            x = min.x + (w << 6) + std::countr_zero(free);
+            return true;
         }
-        i++;
-        x = -i;
-        y = -i;
     }
+    return false;
 }
 
-Universe::Universe()
+template<typename T>
+void swapRemove(std::vector<T>& v, u32 slot)
 {
+    v[slot] = v.back();
+    v.pop_back();
 }
 
-Universe::~Universe()
+u32 MoverArrays::add(UShip* s)
 {
-    for (auto it : actor_ids)
+    u32 slot = size();
+    ship.push_back(s);
+    id.push_back(s->id);
+    type.push_back(s->type);
+    flags.push_back(0);
+    pos.push_back(s->own_pos);
+    vel.push_back(s->own_vel);
+    track_pos.push_back(vec2i());
+    track_vel.push_back(vec2i());
+    dist.push_back(0.0f);
+    s->movers = this;
+    s->mover_slot = slot;
+    return slot;
+}
+
+void MoverArrays::remove(u32 slot)
+{
+    UShip* s = ship[slot];
+    s->own_pos = pos[slot];
+    s->own_vel = vel[slot];
+    s->movers = nullptr;
+    s->mover_slot = None;
+    swapRemove(ship, slot);
+    swapRemove(id, slot);
+    swapRemove(type, slot);
+    swapRemove(flags, slot);
+    swapRemove(pos, slot);
+    swapRemove(vel, slot);
+    swapRemove(track_pos, slot);
+    swapRemove(track_vel, slot);
+    swapRemove(dist, slot);
+    if (slot < size())
+        ship[slot]->mover_slot = slot;
+}
+
+void MoverArrays::classify(u32 begin, u32 end, vec2i origin, float scanner_range)
+{
+    // Frozen movers are out of the actor table, nothing is in their way.
+    for (u32 i = begin; i < end; ++i)
     {
-        delete it.value;
+        if (flags[i] & Frozen)
+            pos[i] += vel[i];
+    }
+    for (u32 i = begin; i < end; ++i)
+        dist[i] = (pos[i] - origin).length();
+    // Anything past LodUnloadRange is unloaded by the update.
+    for (u32 i = begin; i < end; ++i)
+    {
+        if (dist[i] > LodUnloadRange) continue;
+        if (dist[i] > scanner_range && !(flags[i] & Tracked))
+        {
+            flags[i] |= Tracked;
+            track_pos[i] = pos[i];
+            track_vel[i] = vel[i];
+        }
+        // Only its position is kept up to date until it comes back.
+        if (dist[i] > LodCoarseRange)
+            flags[i] |= Frozen;
     }
 }
 
+bool Universe::isOccupied(vec2i p)
+{
+    return occupancy.contains(p) ? occupancy.test(p) : actors.find(p).found;
+}
+
+void Universe::place(vec2i p, UActor* a)
+{
+    actors.insert(p, a);
+    occupancy.set(p, true);
+}
+
+bool Universe::unplace(vec2i p)
+{
+    occupancy.set(p, false);
+    return actors.erase(p);
+}
+
+void Universe::recenterOccupancy(vec2i origin)
+{
+    // Rebuilt well before anything loaded can get near the edge.
+    vec2i center = occupancy.min + vec2i(OccupancyGrid::Size / 2, OccupancyGrid::Size / 2);
+    if (!occupancy.bits.empty() && abs(origin.x - center.x) <= 16 && abs(origin.y - center.y) <= 16)
+        return;
+    PROFILE_ZONE("recenterOccupancy");
+    occupancy.reset(origin);
+    for (auto it : actors)
+        occupancy.set(it.key, true);
+}
+
 bool Universe::isVisible(vec2i from, vec2i to)
 {
     auto points = findRay(from, to);
@@ -854,7 +1050,7 @@ bool Universe::checkArea(vec2i pos, int radius)
     {
         for (int y = -radius; y <= radius; ++y)
         {
-            if (actors.find(pos + vec2i(x, y)).found)
+            if (isOccupied(pos + vec2i(x, y)))
                 return false;
         }
     }
@@ -864,10 +1060,10 @@ bool Universe::checkArea(vec2i pos, int radius)
 void Universe::move(UActor* a, vec2i d)
 {
     debug_assert(isShipType(a->type));
-    bool target_occupied = actors.find(a->pos + d).found;
-    std::vector<vec2i> steps = findRay(a->pos, a->pos + d);
+    bool target_occupied = actors.find(a->pos() + d).found;
+    frame_vector<vec2i> steps = findRay(a->pos(), a->pos() + d);
     bool warned_this_step = false;
-    vec2i last = a->pos;
+    vec2i last = a->pos();
     for (vec2i p: steps)
     {
         auto it = actors.find(p);
@@ -910,16 +1106,21 @@ void Universe::move(UActor* a, vec2i d)
                     }
                     t->dead = true;
                 }
-                else if (p.x == a->pos.x + d.x && p.y == a->pos.y + d.y)
+                else if (p.x == a->pos().x + d.x && p.y == a->pos().y + d.y)
                 {
                     UActor* torp = it.value;
+                    vec2i p0;
+                    if (!findEmpty(p, p0))
+                    {
+                        // Nowhere to push it aside, stop short of it instead.
+                        pl->vel() = vec2i(0, 0);
+                        break;
+                    }
                     last = p;
-                    vec2i p0 = findEmpty(p);
-                    bool rem = actors.erase(p);
+                    bool rem = unplace(p);
                     debug_assert(rem);
-                    torp->pos = p0;
-                    debug_assert(!actors.find(p0).found);
-                    actors.insert(torp->pos, torp);
+                    torp->pos() = p0;
+                    place(torp->pos(), torp);
                     continue;
                 }
             }
@@ -958,7 +1159,7 @@ void Universe::move(UActor* a, vec2i d)
                     break;
                 }
             }
-            else if (pl->vel.length() > 6)
+            else if (pl->vel().length() > 6)
             {
                 if (a == g_game.uplayer)
                 {
@@ -968,13 +1169,13 @@ void Universe::move(UActor* a, vec2i d)
                 }
 
                 vec2f dir = vec2f(rng.nextFloat() - 0.5f, 2.0f).normalize();
-                pl->ship->explosion(dir, rng.nextFloat() * 3 * pl->vel.length() + 5);
-                pl->vel = vec2i(0, 0);
+                pl->ship->explosion(dir, rng.nextFloat() * 3 * pl->vel().length() + 5);
+                pl->vel() = vec2i(0, 0);
                 break;
             }
             else if (it.value->type == UActorType::Asteroid)
             {
-                if (pl->vel.length() > 2)
+                if (pl->vel().length() > 2)
                 {
                     if (a == g_game.uplayer)
                     {
@@ -984,14 +1185,14 @@ void Universe::move(UActor* a, vec2i d)
                     }
 
                     vec2f dir = vec2f(rng.nextFloat() - 0.5f, 2.0f).normalize();
-                    pl->ship->explosion(dir, rng.nextFloat() * 3 * pl->vel.length() + 5);
+                    pl->ship->explosion(dir, rng.nextFloat() * 3 * pl->vel().length() + 5);
                 }
                 else if (!warned_this_step)
                 {
                     if (a == g_game.uplayer) g_game.log.log("Collision avoidance activated!");
                     warned_this_step = true;
                 }
-                pl->vel = vec2i(0, 0);
+                pl->vel() = vec2i(0, 0);
                 break;
             }
             else if (!target_occupied)
@@ -1009,7 +1210,7 @@ void Universe::move(UActor* a, vec2i d)
                     if (a == g_game.uplayer) g_game.log.log("Collision avoidance activated!");
                     warned_this_step = true;
                 }
-                pl->vel = vec2i(0, 0);
+                pl->vel() = vec2i(0, 0);
                 break;
             }
         }
@@ -1018,43 +1219,79 @@ void Universe::move(UActor* a, vec2i d)
             last = p;
         }
     }
-    if (a->pos != last)
+    if (a->pos() != last)
+        moveTo(a, last);
+}
+
+bool Universe::moveIfClear(UActor* a, vec2i d)
+{
+    frame_vector<vec2i> steps = findRay(a->pos(), a->pos() + d);
+    for (vec2i p : steps)
+    {
+        if (!occupancy.contains(p) || occupancy.test(p))
+            return false;
+    }
+    if (!steps.empty())
+        moveTo(a, steps.back());
+    return true;
+}
+
+void Universe::moveTo(UActor* a, vec2i p)
+{
+    if (g_game.uplayer)
     {
-        if (g_game.uplayer)
+        if (g_game.show_universe && a != g_game.uplayer && (a->pos() - g_game.uplayer->pos()).length() < g_game.uplayer->ship->scannerRange())
         {
-            if (g_game.show_universe && a != g_game.uplayer && (a->pos - g_game.uplayer->pos).length() < g_game.uplayer->ship->scannerRange())
-            {
-                ShipMoveAnimation* anim = new ShipMoveAnimation((UShip*)a, a->pos, last);
-                g_game.uanimations.push_back(anim);
-            }
+            g_game.uanimations.shipMove((UShip*)a, a->pos(), p);
         }
-
-        bool rem = actors.erase(a->pos);
-        debug_assert(rem);
-        a->pos = last;
-        debug_assert(!actors.find(last).found);
-        actors.insert(a->pos, a);
     }
+
+    bool rem = unplace(a->pos());
+    debug_assert(rem);
+    a->pos() = p;
+    place(a->pos(), a);
 }
 
-vec2i Universe::findEmpty(vec2i p0)
+bool Universe::findEmpty(vec2i p, vec2i& out, int max_radius)
 {
-    vec2i p = p0;
-    int i = 0;
-    int x = 0;
-    int y = 0;
-    while (actors.find(p).found)
+    PROFILE_ZONE("findEmpty");
+    for (int r = 0; r <= max_radius; ++r)
     {
-        p = p0 + getOffset(i, x, y);
+        bool in_grid = occupancy.contains(p - vec2i(r, r)) && occupancy.contains(p + vec2i(r, r));
+        for (int y = p.y - r; y <= p.y + r; ++y)
+        {
+            bool edge = y == p.y - r || y == p.y + r;
+            if (in_grid && edge)
+            {
+                int x;
+                if (occupancy.firstFree(y, p.x - r, p.x + r, x))
+                {
+                    out = vec2i(x, y);
+                    return true;
+                }
+                continue;
+            }
+            // Rows between the top and bottom of the ring only have its two ends.
+            for (int x = p.x - r; x <= p.x + r; x += edge ? 1 : 2 * r)
+            {
+                vec2i c(x, y);
+                if (in_grid ? !occupancy.test(c) : !actors.find(c).found)
+                {
+                    out = c;
+                    return true;
+                }
+            }
+        }
     }
-    return p;
+    return false;
 }
 
-void Universe::spawn(UActor* a)
+bool Universe::spawn(UActor* a)
 {
-    vec2i p = findEmpty(a->pos);
-    actors.insert(p, a);
-    a->pos = p;
+    vec2i p;
+    if (!findEmpty(a->pos(), p)) return false;
+    place(p, a);
+    a->pos() = p;
 
     if (a->type == UActorType::Asteroid)
     {
@@ -1063,29 +1300,196 @@ void Universe::spawn(UActor* a)
         for (float a = 0; a + step / 2 < scalar::PIf * 2; a += step)
         {
             float r = (ast->radius + (float) cos(a * 1.2 + ast->sfreq) * ast->radius);
-            vec2i p = ast->pos + vec2i((int)round(cos(a) * r), (int)round(sin(a) * r));
+            vec2i p = ast->pos() + vec2i((int)round(cos(a) * r), (int)round(sin(a) * r));
             for (int r0 = 0; r0 < r; ++r0)
             {
-                vec2i p0 = ast->pos + vec2i((int)round(cos(a) * r0), (int)round(sin(a) * r0));
-                if (actors.find(p0).found) continue;
-                actors.insert(p0, (UActor*) ast);
+                vec2i p0 = ast->pos() + vec2i((int)round(cos(a) * r0), (int)round(sin(a) * r0));
+                if (isOccupied(p0)) continue;
+                place(p0, (UActor*) ast);
             }
-            if (!actors.find(p).found)
-                actors.insert(p, (UActor*)ast);
+            if (!isOccupied(p))
+                place(p, (UActor*)ast);
         }
     }
-    else if (a->type == UActorType::Torpedo)
-    {
-        torpedoes.push_back((UTorpedo*) a);
-    }
     a->id = next_actor++;
     actor_ids.insert(a->id, a);
+    if (isShipType(a->type))
+    {
+        movers.add((UShip*)a);
+    }
+    if (a->type == UActorType::Torpedo)
+    {
+        addTorpedo((UTorpedo*) a);
+    }
+    return true;
+}
+
+void Universe::addTorpedo(UTorpedo* t)
+{
+    t->registry_index = (u32)torpedoes.size();
+    torpedoes.push_back(t);
+    // Not linked yet, whatever it was aimed at before spawning.
+    u32 target = t->target;
+    t->target = 0;
+    retarget(t, target);
+}
+
+void Universe::removeTorpedo(UTorpedo* t)
+{
+    retarget(t, 0);
+    debug_assert(torpedoes[t->registry_index] == t);
+    UTorpedo* moved = torpedoes.back();
+    torpedoes[t->registry_index] = moved;
+    moved->registry_index = t->registry_index;
+    torpedoes.pop_back();
+}
+
+void Universe::retarget(UTorpedo* t, u32 target)
+{
+    if (t->target != 0)
+    {
+        auto list = incoming.find(t->target);
+        debug_assert(list.found);
+        if (t->prev_incoming) t->prev_incoming->next_incoming = t->next_incoming;
+        else list.value.first = t->next_incoming;
+        if (t->next_incoming) t->next_incoming->prev_incoming = t->prev_incoming;
+        else list.value.last = t->prev_incoming;
+        if (!list.value.first) incoming.erase(t->target);
+        t->prev_incoming = t->next_incoming = nullptr;
+    }
+
+    t->target = target;
+    if (target == 0) return;
+    auto list = incoming.find(target);
+    if (!list.found)
+    {
+        incoming.insert(target, IncomingTorpedoes{ t, t });
+        return;
+    }
+    t->prev_incoming = list.value.last;
+    list.value.last->next_incoming = t;
+    list.value.last = t;
+}
+
+UTorpedo* Universe::incomingTorpedoes(u32 target)
+{
+    if (target == 0) return nullptr;
+    auto list = incoming.find(target);
+    return list.found ? list.value.first : nullptr;
+}
+
+// Broadphase cells are 8x8.
+constexpr int BroadphaseCellShift = 3;
+
+u64 broadphaseCell(int x, int y)
+{
+    return ((u64)(u32)(x >> BroadphaseCellShift) << 32) | (u32)(y >> BroadphaseCellShift);
+}
+
+// Box covered by one ship's path this tick.
+struct SweptMove
+{
+    u32 slot;
+    u32 id;
+    vec2i from;
+    vec2i lo, hi;
+    bool contested;
+};
+
+// Moves every ship by its velocity. Two ships can only run into each other if their swept
+// boxes overlap, found by binning the boxes into cells, and everything else can only hit
+// actors that stay put this tick. Those moves go first, then the contested ones, each in
+// id order so the result doesn't depend on how the actor table is laid out. An uncontested
+// ship whose path is clear in the occupancy grid skips the per-cell actor lookups.
+void moveShips(Universe* u, const frame_vector<u32>& slots, frame_vector<UActor*>& to_remove)
+{
+    MoverArrays& mv = u->movers;
+    frame_vector<SweptMove> sweeps;
+    for (u32 i : slots)
+    {
+        // Something updated after it may have killed it.
+        if (mv.vel[i].zero() || mv.ship[i]->dead) continue;
+        vec2i from = mv.pos[i];
+        vec2i to = from + mv.vel[i];
+        vec2i lo(scalar::min(from.x, to.x), scalar::min(from.y, to.y));
+        vec2i hi(scalar::max(from.x, to.x), scalar::max(from.y, to.y));
+        sweeps.push_back(SweptMove{ i, mv.id[i], from, lo, hi, false });
+    }
+    std::sort(sweeps.begin(), sweeps.end(), [](const SweptMove& a, const SweptMove& b) { return a.id < b.id; });
+
+    frame_vector<std::pair<u64, u32>> bins;
+    for (u32 i = 0; i < (u32)sweeps.size(); ++i)
+    {
+        const SweptMove& m = sweeps[i];
+        for (int y = m.lo.y >> BroadphaseCellShift; y <= m.hi.y >> BroadphaseCellShift; ++y)
+        {
+            for (int x = m.lo.x >> BroadphaseCellShift; x <= m.hi.x >> BroadphaseCellShift; ++x)
+                bins.push_back({ broadphaseCell(x << BroadphaseCellShift, y << BroadphaseCellShift), i });
+        }
+    }
+    std::sort(bins.begin(), bins.end());
+
+    int pairs = 0;
+    for (size_t run = 0; run < bins.size();)
+    {
+        size_t end = run + 1;
+        while (end < bins.size() && bins[end].first == bins[run].first) end++;
+        for (size_t i = run; i < end; ++i)
+        {
+            for (size_t j = i + 1; j < end; ++j)
+            {
+                SweptMove& a = sweeps[bins[i].second];
+                SweptMove& b = sweeps[bins[j].second];
+                if (a.hi.x < b.lo.x || b.hi.x < a.lo.x || a.hi.y < b.lo.y || b.hi.y < a.lo.y) continue;
+                // Boxes can share several cells, only count the pair in the one holding the
+                // corner of their overlap.
+                if (broadphaseCell(scalar::max(a.lo.x, b.lo.x), scalar::max(a.lo.y, b.lo.y)) != bins[run].first) continue;
+                a.contested = b.contested = true;
+                pairs++;
+            }
+        }
+        run = end;
+    }
+
+    int fast_moves = 0;
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        for (SweptMove& m : sweeps)
+        {
+            UShip* s = mv.ship[m.slot];
+            if (m.contested != (pass == 1) || s->dead) continue;
+            if (pass == 0)
+            {
+                // A torpedo pushed aside by an earlier move no longer starts where its box
+                // does, leave it to the contested pass.
+                if (s->pos() != m.from)
+                {
+                    m.contested = true;
+                    continue;
+                }
+                if (u->moveIfClear(s, mv.vel[m.slot]))
+                {
+                    fast_moves++;
+                    continue;
+                }
+            }
+            u->move(s, mv.vel[m.slot]);
+            if (s->dead)
+                to_remove.push_back(s);
+        }
+    }
+
+    profileCounter("movers", (s64)sweeps.size());
+    profileCounter("contested_moves", pairs);
+    profileCounter("clear_moves", fast_moves);
 }
 
 void Universe::update(vec2i origin)
 {
+    PROFILE_ZONE("Universe::update");
     universe_ticks++;
-    std::vector<vec2i> refresh_regions;
+    recenterOccupancy(origin);
+    frame_vector<vec2i> refresh_regions;
     for (auto it : regions_generated)
     {
         vec2i center((it.key.x << 5) + 16, (it.key.y << 5) + 16);
@@ -1094,6 +1498,24 @@ void Universe::update(vec2i origin)
     }
     for (vec2i r : refresh_regions) regions_generated.erase(r);
 
+    ProfileScope populate_zone("populate regions");
+    // Ships are spawned immediately so later placement checks see them, but their
+    // layouts are generated together once all regions are populated.
+    std::vector<UShip*> pending_ships;
+    std::vector<GenerateRequest> pending_requests;
+    std::vector<u64> pending_seeds;
+    auto queueShip = [&](UShip* s, const char* name, const char* type)
+    {
+        if (!spawn(s))
+        {
+            delete s;
+            return;
+        }
+        pending_ships.push_back(s);
+        pending_requests.push_back(GenerateRequest{ name, type });
+        pending_seeds.push_back(rng.nextLong());
+    };
+
     for (int y = origin.y - 70; y < origin.y + 70; y += 32)
     {
         int ry = y >> 5;
@@ -1119,7 +1541,7 @@ void Universe::update(vec2i origin)
                             UAsteroid* a = new UAsteroid(vec2i((rx << 5) + (x0 << 3), (ry << 5) + (y0 << 3)), color, icolor);
                             a->sfreq = rng.nextFloat() * 10;
                             a->radius = 1.0f + rng.nextFloat() * 2.0f + rng.nextFloat() * rng.nextFloat() * 8.0f;
-                            spawn(a);
+                            if (!spawn(a)) delete a;
                         }
                         else
                         {
@@ -1132,33 +1554,29 @@ void Universe::update(vec2i origin)
                                     float type = rng.nextFloat();
                                     if (type < pcts.cargo)
                                     {
-                                        UCargoShip* s = new UCargoShip(p);
-                                        spawn(s);
+                                        queueShip(new UCargoShip(p), "cargo", "cargo_ship");
                                     }
                                     else if (type < pcts.pirate)
                                     {
-                                        UPirateShip* s = new UPirateShip(p, 'P', 0xFFFF0000);
-                                        spawn(s);
+                                        queueShip(new UPirateShip(p, 'P', 0xFFFF0000), "pirate", "pirate_ship");
                                     }
                                     else if(type < pcts.station)
                                     {
                                         UStation* s = new UStation(p);
-                                        spawn(s);
+                                        if (!spawn(s)) delete s;
                                     }
                                     else if(type < pcts.military)
                                     {
-                                        UPirateShip* s = new UPirateShip(p, 'M', 0xFFFF0000);
-                                        spawn(s);
+                                        queueShip(new UPirateShip(p, 'M', 0xFFFF0000), "pirate", "pirate_ship");
                                     }
                                     else if(type < pcts.mil_station)
                                     {
                                         UMilitaryStation* s = new UMilitaryStation(p);
-                                        spawn(s);
+                                        if (!spawn(s)) delete s;
                                     }
                                     else if(type < pcts.alient_remenant && !has_spawned_alien)
                                     {
-                                        UPirateShip* s = new UPirateShip(p, 'A', 0xFFFF00FF);
-                                        spawn(s);
+                                        queueShip(new UPirateShip(p, 'A', 0xFFFF00FF), "pirate", "pirate_ship");
                                     }
                                 }
                             }
@@ -1171,30 +1589,52 @@ void Universe::update(vec2i origin)
         }
     }
 
+    populate_zone.end();
+
+    if (!pending_ships.empty())
+    {
+        PROFILE_ZONE("adopt ships");
+        std::vector<Ship*> ships = generateBatch(pending_requests.data(), pending_seeds.data(), (int)pending_ships.size());
+        for (size_t i = 0; i < ships.size(); ++i)
+            pending_ships[i]->adoptShip(ships[i]);
+    }
+
     float player_scanners = g_game.uplayer ? g_game.uplayer->ship->scannerRange() : 1000;
-    std::vector<UShip*> moved;
-    std::vector<UActor*> to_remove;
+    // A disabled scanner shouldn't make nearby pirates go quiet.
+    float full_range = scalar::max(player_scanners, LodMinScannerRange) + LodFullMargin;
+    int lod_counts[3]{ 0, 0, 0 };
+
+    ProfileScope classify_zone("classify movers");
+    MoverArrays& mv = movers;
+    u32 mover_count = mv.size();
+    mv.classify(0, mover_count, origin, player_scanners);
+    classify_zone.end();
+
+    frame_vector<u32> moved;
+    frame_vector<UShip*> frozen;
+    frame_vector<u32> thawed;
+    frame_vector<UActor*> to_remove;
+    ProfileScope update_zone("update actors");
     for (auto it : actors)
     {
         UActor* a = it.value;
-        if (a->pos != it.key)
+        if (a->pos() != it.key)
         {
             debug_assert(a->type == UActorType::Asteroid);
             continue; // Proxy actor
         }
-        if ((a->pos - origin).length() > 160.0f)
+        UShip* ship = isShipType(a->type) ? (UShip*)a : nullptr;
+        u32 slot = ship ? ship->mover_slot : MoverArrays::None;
+        // Torpedoes fired earlier in this loop can come up before it ends.
+        if (ship && slot >= mover_count)
+            mv.classify(slot, slot + 1, origin, player_scanners);
+        float dist = ship ? mv.dist[slot] : (a->pos() - origin).length();
+        if (dist > LodUnloadRange)
         {
             to_remove.push_back(a);
             continue;
         }
-        else if ((a->pos - origin).length() > player_scanners && isShipType(a->type))
-        {
-            if (!lost_tracks.find(a->id).found)
-            {
-                lost_tracks.insert(a->id, ULostTrack(a->pos, ((UShip*)a)->vel, 0xFFFF0000, a->id));
-            }
-        }
-        else if (a->type == UActorType::PirateShip)
+        else if (dist <= player_scanners && a->type == UActorType::PirateShip)
         {
             UPirateShip* pirate = (UPirateShip*)a;
             if (!pirate->has_alerted)
@@ -1203,33 +1643,80 @@ void Universe::update(vec2i origin)
                 g_game.log.log("[Alert] New hostile contact in sensor range!");
             }
         }
-        a->update(rng);
+
+        // Frozen ships leave actors, so any still here froze this tick.
+        if (ship && (mv.flags[slot] & MoverArrays::Frozen))
+        {
+            frozen.push_back(ship);
+            continue;
+        }
+
+        if (dist > full_range)
+        {
+            // Staggered by id so the coarse ticks are spread out.
+            lod_counts[1]++;
+            if ((universe_ticks + a->id) % LodCoarseInterval == 0)
+                a->coarseUpdate(rng, LodCoarseInterval);
+        }
+        else
+        {
+            lod_counts[0]++;
+            a->update(rng);
+        }
 
         if (a->dead)
         {
             to_remove.push_back(a);
         }
-        else if (isShipType(a->type))
+        else if (ship)
         {
-            moved.push_back((UShip*) a);
+            moved.push_back(slot);
         }
     }
-    for (UShip* a : moved)
+    update_zone.end();
+
+    // A frozen ship is only in actor_ids and the mover arrays. Leaving it at the cell it froze
+    // at would block and show a ship that has long since drifted away.
+    for (UShip* s : frozen)
     {
-        if (a->dead) continue;
-        if (!a->vel.zero())
-        {
-            move(a, a->vel);
-            if (a->dead)
-            {
-                to_remove.push_back(a);
-            }
-        }
+        bool rem = unplace(s->pos());
+        debug_assert(rem);
     }
+    for (u32 i = 0; i < mv.size(); ++i)
+    {
+        if (!(mv.flags[i] & MoverArrays::Frozen)) continue;
+        if (mv.dist[i] > LodUnloadRange)
+            to_remove.push_back(mv.ship[i]);
+        else if (mv.dist[i] > LodCoarseRange - LodThawMargin)
+            lod_counts[2]++;
+        else
+            thawed.push_back(i);
+    }
+    // Slots are not in spawn order after a load.
+    std::sort(thawed.begin(), thawed.end(), [&](u32 a, u32 b) { return mv.id[a] < mv.id[b]; });
+
+    // Ships coming back from the edge are placed at the nearest free cell to where they
+    // drifted to. They are simulated again from the next tick on.
+    for (u32 slot : thawed)
+    {
+        vec2i p;
+        // Stays frozen until there is room for it.
+        if (!findEmpty(mv.pos[slot], p)) continue;
+        mv.pos[slot] = p;
+        place(p, mv.ship[slot]);
+        mv.flags[slot] &= ~MoverArrays::Frozen;
+    }
+
+    ProfileScope move_zone("move ships");
+    moveShips(this, moved, to_remove);
+    move_zone.end();
+
+    ProfileScope remove_zone("remove actors");
     for (UActor* a : to_remove)
     {
         if (a->type == UActorType::Player) continue;
-        bool rem = actors.erase(a->pos);
+        bool in_actors = !isShipType(a->type) || !(mv.flags[((UShip*)a)->mover_slot] & MoverArrays::Frozen);
+        bool rem = !in_actors || unplace(a->pos());
         debug_assert(rem);
         rem = actor_ids.erase(a->id);
         debug_assert(rem);
@@ -1242,10 +1729,10 @@ void Universe::update(vec2i origin)
             {
                 for (int x = -r2; x <= r2; ++x)
                 {
-                    vec2i p = a->pos + vec2i(x, y);
+                    vec2i p = a->pos() + vec2i(x, y);
                     auto it = actors.find(p);
                     if (it.found && it.value == a)
-                        actors.erase(p);
+                        unplace(p);
                 }
             }
         }
@@ -1253,8 +1740,8 @@ void Universe::update(vec2i origin)
         {
             if (a->dead)
             {
-                UShipWreck* wreck = new UShipWreck(a->pos);
-                spawn(wreck);
+                UShipWreck* wreck = new UShipWreck(a->pos());
+                if (!spawn(wreck)) delete wreck;
             }
             if (a->type == UActorType::PirateShip && ((UPirateShip*)a)->character == 'A')
             {
@@ -1270,40 +1757,59 @@ void Universe::update(vec2i origin)
         }
         else if (a->type == UActorType::Torpedo)
         {
-            torpedoes.erase(std::find(torpedoes.begin(), torpedoes.end(), a));
+            removeTorpedo((UTorpedo*)a);
+        }
+        if (isShipType(a->type))
+        {
+            mv.remove(((UShip*)a)->mover_slot);
         }
         delete a;
     }
+    remove_zone.end();
 
-    for (auto it: lost_tracks)
+    PROFILE_ZONE("lost tracks");
+    int lost_tracks = 0;
+    for (u32 i = 0; i < mv.size(); ++i)
     {
-        auto actor_it = actor_ids.find(it.key);
-        if (!actor_it.found || (it.value.pos - origin).length() > 160.0f || (it.value.pos - origin).length() < player_scanners || ((actor_it.value->pos - origin).length() <= player_scanners && isVisible(actor_it.value->pos, origin)))
+        if (!(mv.flags[i] & MoverArrays::Tracked)) continue;
+        float track_dist = (mv.track_pos[i] - origin).length();
+        if (track_dist > LodUnloadRange || track_dist < player_scanners || ((mv.pos[i] - origin).length() <= player_scanners && isVisible(mv.pos[i], origin)))
         {
-            lost_tracks.erase(it.key);
+            mv.flags[i] &= ~MoverArrays::Tracked;
             continue;
         }
-        it.value.pos += it.value.vel;
+        mv.track_pos[i] += mv.track_vel[i];
+        lost_tracks++;
     }
+
+    profileCounter("actors", actors.size());
+    profileCounter("actor_ids", actor_ids.size());
+    profileCounter("lost_tracks", lost_tracks);
+    profileCounter("lod_full", lod_counts[0]);
+    profileCounter("lod_coarse", lod_counts[1]);
+    profileCounter("lod_extrapolated", lod_counts[2]);
+    profileCounter("regions_generated", regions_generated.size());
+    profileCounter("ships", (s64)g_game.ships.size());
 }
 
 void Universe::render(TextBuffer& buffer, vec2i origin)
 {
+    PROFILE_ZONE("Universe::render");
     float pscanner = g_game.uplayer ? g_game.uplayer->ship->scannerRange() : 1000;
     vec2i bl = origin - vec2i((g_game.w - 30) / 2, g_game.h / 2);
     for (auto it : actors)
     {
-        if (it.value->pos == it.key)
+        if (it.value->pos() == it.key)
         {
 #if 0
-            auto lost = lost_tracks.find(it.value->id);
-            if (lost.found)
+            u32 slot = isShipType(it.value->type) ? ((UShip*)it.value)->mover_slot : MoverArrays::None;
+            if (slot != MoverArrays::None && (movers.flags[slot] & MoverArrays::Tracked))
             {
-                buffer.setOverlay(lost.value.pos, lost.value.color, LayerPriority_Overlay);
+                buffer.setOverlay(movers.track_pos[slot], 0xFFFF0000, LayerPriority_Overlay);
             }
             else
 #else
-            if (it.value->type == UActorType::Asteroid || (it.value->pos - origin).length() < pscanner)
+            if (it.value->type == UActorType::Asteroid || (it.value->pos() - origin).length() < pscanner)
 #endif
                 it.value->render(buffer, bl);
         }
@@ -24,18 +24,69 @@ enum class UActorType
 constexpr int UActorTypeCount = int(UActorType::__COUNT);
 extern const char* UActorTypeNames[UActorTypeCount];
 
+bool isShipType(UActorType t);
+
+struct UShip;
+
+// Kinematic state of every ship and torpedo in parallel arrays, one slot per mover. A
+// registered actor's pos() and vel() point into its slot, so the per tick range checks,
+// culling and drift of frozen movers run over dense arrays.
+struct MoverArrays
+{
+    static constexpr u32 None = ~0u;
+
+    enum Flag : u8
+    {
+        // Not simulated, only drifts by vel every tick until it comes back into range.
+        Frozen = 1,
+        // Out of scanner range, track_pos is where it looked to be heading.
+        Tracked = 2,
+    };
+
+    std::vector<UShip*> ship;
+    std::vector<u32> id;
+    std::vector<UActorType> type;
+    std::vector<u8> flags;
+    std::vector<vec2i> pos;
+    std::vector<vec2i> vel;
+    std::vector<vec2i> track_pos;
+    std::vector<vec2i> track_vel;
+    // Distance from the player, worked out at the start of each update.
+    std::vector<float> dist;
+
+    u32 size() const { return (u32)ship.size(); }
+    // Moves the ship's pos and vel into a new slot.
+    u32 add(UShip* s);
+    // Hands pos and vel back to the ship and fills the gap with the last slot.
+    void remove(u32 slot);
+    // Drifts frozen movers and works out dist for a range of slots, then starts lost tracks
+    // for the ones past scanner_range and freezes the ones too far out to simulate.
+    void classify(u32 begin, u32 end, vec2i origin, float scanner_range);
+};
+
 struct UActor
 {
     u32 id = 0;
     UActorType type;
-    vec2i pos;
 
     bool dead = false;
 
-    UActor(UActorType type, vec2i p) : type(type), pos(p) {}
+    // Set while a ship or torpedo is registered in Universe::movers.
+    MoverArrays* movers = nullptr;
+    u32 mover_slot = MoverArrays::None;
+    // Position while the actor has no mover slot, everything else and unspawned ships.
+    vec2i own_pos;
+
+    UActor(UActorType type, vec2i p) : type(type), own_pos(p) {}
     virtual ~UActor() {}
 
+    // Don't hold on to the reference, spawning a ship can move the arrays.
+    vec2i& pos() { return movers ? movers->pos[mover_slot] : own_pos; }
+    const vec2i& pos() const { return movers ? movers->pos[mover_slot] : own_pos; }
+
     virtual void update(pcg32& rng) {}
+    // Stands in for update() out past the player's sensors, called once every `ticks` ticks.
+    virtual void coarseUpdate(pcg32& rng, int ticks) {}
     virtual void render(TextBuffer& buffer, vec2i origin) = 0;
 };
 
@@ -54,18 +105,28 @@ struct UAsteroid : UActor
 
 struct UShip : UActor
 {
-    vec2i vel;
     Ship* ship = nullptr;
 
     bool animating = false;
 
+    // Velocity while the ship has no mover slot.
+    vec2i own_vel;
+
     UShip(UActorType t, vec2i p) : UActor(t, p) {}
     ~UShip();
 
+    vec2i& vel() { return movers ? movers->vel[mover_slot] : own_vel; }
+    const vec2i& vel() const { return movers ? movers->vel[mover_slot] : own_vel; }
+
     virtual void update(pcg32& rng) override;
+    virtual void coarseUpdate(pcg32& rng, int ticks) override;
+    // Takes ownership of a generated ship layout and registers it with the game.
+    virtual void adoptShip(Ship* s);
 
     bool fireTorpedo(vec2i target, int power);
     bool fireRailgun(vec2i target, int power);
+    // Drifts at a low speed, slowing down when something is in the way.
+    void wander(pcg32& rng);
 };
 
 struct UCargoShip : UShip
@@ -73,6 +134,8 @@ struct UCargoShip : UShip
     UCargoShip(vec2i p);
 
     void update(pcg32& rng) override;
+    void coarseUpdate(pcg32& rng, int ticks) override;
+    void adoptShip(Ship* s) override;
 
     void render(TextBuffer& buffer, vec2i origin) override;
 };
@@ -102,10 +165,15 @@ struct UPirateShip : UShip
     UPirateShip(vec2i p, int c, u32 col);
 
     void update(pcg32& rng) override;
+    void coarseUpdate(pcg32& rng, int ticks) override;
+    void adoptShip(Ship* s) override;
 
     void render(TextBuffer& buffer, vec2i origin) override;
 
     bool isTarget(UActor* actor);
+    // Chases the target's last known position, or wanders without one.
+    void steer(pcg32& rng);
+    void reloadWeapons(int ticks);
 };
 
 struct UPlayer : UShip
@@ -134,16 +202,28 @@ struct UPlayer : UShip
 struct UTorpedo : UShip
 {
     vec2i target_pos;
+    // Change through Universe::retarget once spawned, it keeps the incoming index.
     u32 target = 0;
     u32 source = 0;
 
     int power;
 
+    // Slot in Universe::torpedoes and links in the target's incoming list.
+    u32 registry_index = 0;
+    UTorpedo* prev_incoming = nullptr;
+    UTorpedo* next_incoming = nullptr;
+
     UTorpedo(vec2i p, int power) : UShip(UActorType::Torpedo, p), power(power) {}
 
     void update(pcg32& rng) override;
+    void coarseUpdate(pcg32& rng, int ticks) override;
 
     void render(TextBuffer& buffer, vec2i origin) override;
+
+    // Refreshes target_pos and the target's velocity, self-destructs if the target is gone.
+    bool trackTarget(vec2i& tvel);
+    // One step of thrust towards dist away, braking to match tvel on arrival.
+    void steer(vec2i dist, vec2i tvel);
 };
 
 struct UStation : UActor
@@ -187,14 +267,36 @@ struct UMilitaryStation : UActor
 
 };
 
-struct ULostTrack
+// One bit per cell for a window around the player, set where Universe::actors has an entry,
+// so free cells can be found a word at a time instead of with a hash probe per cell.
+struct OccupancyGrid
 {
-    vec2i pos;
-    vec2i vel;
-    u32 color;
-    u32 id;
+    // Cells per side, a multiple of 64. Covers everything loaded with room to drift.
+    static constexpr int Size = 384;
+    static constexpr int Words = Size / 64;
+
+    // World cell of the first bit, the grid is empty until the first reset.
+    vec2i min;
+    std::vector<u64> bits;
+
+    void reset(vec2i center);
+    bool contains(vec2i p) const;
+    // p must be inside the grid.
+    bool test(vec2i p) const;
+    // Ignored outside the grid.
+    void set(vec2i p, bool taken);
+    // First free cell of row y from x0 to x1 inclusive, which must be inside the grid.
+    bool firstFree(int y, int x0, int x1, int& x) const;
+};
+
+// How far findEmpty looks before giving up, in cells.
+constexpr int FindEmptyRadius = 16;
 
-    ULostTrack(vec2i p, vec2i v, u32 c, u32 i) : pos(p), vel(v), color(c), id(i) {}
+// Torpedoes aimed at one actor, oldest first.
+struct IncomingTorpedoes
+{
+    UTorpedo* first = nullptr;
+    UTorpedo* last = nullptr;
 };
 
 struct Universe
@@ -202,9 +304,12 @@ struct Universe
     linear_map<u32, UActor*> actor_ids;
     linear_map<vec2i, UActor*> actors;
     linear_map<vec2i, bool> regions_generated;
-    linear_map<u32, ULostTrack> lost_tracks;
+    OccupancyGrid occupancy;
+    MoverArrays movers;
 
+    // Every torpedo in flight in no particular order, and the ones aimed at each actor by id.
     std::vector<UTorpedo*> torpedoes;
+    linear_map<u32, IncomingTorpedoes> incoming;
 
     pcg32 rng;
     int universe_ticks = 0;
@@ -216,13 +321,34 @@ struct Universe
     ~Universe();
 
     bool hasActor(vec2i p) { return actors.find(p).found; }
+    bool isOccupied(vec2i p);
 
     bool isVisible(vec2i from, vec2i to);
     bool checkArea(vec2i pos, int radius);
 
+    // Every change to actors goes through these so the occupancy grid stays in step.
+    void place(vec2i p, UActor* a);
+    bool unplace(vec2i p);
+    // Rebuilds the occupancy grid around origin once the player has moved far enough.
+    void recenterOccupancy(vec2i origin);
+
     void move(UActor* a, vec2i d);
-    void spawn(UActor* a);
-    vec2i findEmpty(vec2i p);
+    // Moves a by d only if every cell on the way is free in the occupancy grid, so nothing
+    // can be hit. Returns false without moving it otherwise.
+    bool moveIfClear(UActor* a, vec2i d);
+    // Puts a at p, which must be free, and animates the move if the player can see it.
+    void moveTo(UActor* a, vec2i p);
+    // Takes ownership of a, unless there is no free cell near its position and false is returned.
+    bool spawn(UActor* a);
+
+    void addTorpedo(UTorpedo* t);
+    void removeTorpedo(UTorpedo* t);
+    void retarget(UTorpedo* t, u32 target);
+    // First torpedo aimed at target, follow next_incoming for the rest.
+    UTorpedo* incomingTorpedoes(u32 target);
+    // Nearest free cell to p by rings of increasing Chebyshev distance, false if every cell
+    // within max_radius is taken.
+    bool findEmpty(vec2i p, vec2i& out, int max_radius = FindEmptyRadius);
 
     void update(vec2i origin);
 
@@ -0,0 +1,117 @@
+#include "util/arena.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+constexpr size_t FrameArenaSize = 1 << 20;
+
+Arena::Arena(size_t capacity)
+    : capacity(capacity)
+{
+    overflow.reserve(64);
+}
+
+Arena::~Arena()
+{
+    reset();
+    free(base);
+}
+
+void* Arena::alloc(size_t size, size_t align)
+{
+    // The block is only taken once a thread first allocates, most never do.
+    if (!base) base = (u8*)malloc(capacity);
+
+    size_t offset = (used + align - 1) & ~(align - 1);
+    if (offset + size <= capacity)
+    {
+        last = offset;
+        used = offset + size;
+        return base + offset;
+    }
+
+    overflow_count++;
+    overflow_bytes += size;
+    void* p = malloc(size);
+    overflow.push_back(p);
+    return p;
+}
+
+bool Arena::extend(void* p, size_t new_size)
+{
+    if (p != base + last || last + new_size > capacity) return false;
+    used = last + new_size;
+    return true;
+}
+
+void Arena::reset()
+{
+    if (used + overflow_bytes > peak) peak = used + overflow_bytes;
+    for (void* p : overflow) free(p);
+    overflow.clear();
+    overflow_bytes = 0;
+    used = 0;
+    last = 0;
+}
+
+Arena& frameArena()
+{
+    thread_local Arena arena(FrameArenaSize);
+    return arena;
+}
+
+void frame_string::reserve(u32 extra)
+{
+    u32 needed = length + extra + 1;
+    if (needed <= capacity) return;
+    u32 new_capacity = capacity * 2 > needed ? capacity * 2 : (needed < 64 ? 64 : needed);
+    Arena& arena = frameArena();
+    if (buf && arena.extend(buf, new_capacity))
+    {
+        capacity = new_capacity;
+        return;
+    }
+    char* p = (char*)arena.alloc(new_capacity, 1);
+    if (buf) memcpy(p, buf, length + 1);
+    buf = p;
+    capacity = new_capacity;
+}
+
+void frame_string::append(const char* s)
+{
+    append(s, (u32)strlen(s));
+}
+
+void frame_string::append(const char* s, u32 len)
+{
+    reserve(len);
+    memcpy(buf + length, s, len);
+    length += len;
+    buf[length] = 0;
+}
+
+void frame_string::appendf(const char* fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    vappend(fmt, args);
+    va_end(args);
+}
+
+void frame_string::vappend(const char* fmt, va_list args)
+{
+    // Formats straight into the spare capacity, a second pass is only needed when it runs out.
+    u32 room = capacity - length;
+    va_list copy;
+    va_copy(copy, args);
+    int n = vsnprintf(buf ? buf + length : nullptr, room, fmt, copy);
+    va_end(copy);
+    if (n <= 0) return;
+    if ((u32)n >= room)
+    {
+        reserve((u32)n);
+        vsnprintf(buf + length, n + 1, fmt, args);
+    }
+    length += n;
+}
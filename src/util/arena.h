@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for data that lives for one frame. Nothing is freed on its own, reset() drops
+// every allocation at once. Requests that do not fit are served from the heap and freed by the
+// next reset().
+struct Arena
+{
+    u8* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    // Offset of the most recent allocation, it can grow in place.
+    size_t last = 0;
+
+    std::vector<void*> overflow;
+    size_t overflow_bytes = 0;
+
+    // Highest used + overflow_bytes seen at a reset, and the number of heap fallbacks overall.
+    size_t peak = 0;
+    u64 overflow_count = 0;
+
+    explicit Arena(size_t capacity);
+    ~Arena();
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* alloc(size_t size, size_t align = alignof(std::max_align_t));
+    // Grows p, returned by the latest alloc(), without moving it. Fails if it is not the latest.
+    bool extend(void* p, size_t new_size);
+    void reset();
+};
+
+// Per thread, reset by whichever loop owns the thread at the end of its frame or tick.
+Arena& frameArena();
+
+template<typename T>
+struct ArenaAllocator
+{
+    using value_type = T;
+
+    Arena* arena;
+
+    ArenaAllocator() : arena(&frameArena()) {}
+    ArenaAllocator(Arena& arena) : arena(&arena) {}
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>& o) : arena(o.arena) {}
+
+    T* allocate(size_t n) { return (T*)arena->alloc(n * sizeof(T), alignof(T)); }
+    void deallocate(T*, size_t) {}
+
+    template<typename U>
+    bool operator==(const ArenaAllocator<U>& o) const { return arena == o.arena; }
+    template<typename U>
+    bool operator!=(const ArenaAllocator<U>& o) const { return arena != o.arena; }
+};
+
+// Must not outlive the frame it was filled in.
+template<typename T>
+using frame_vector = std::vector<T, ArenaAllocator<T>>;
+
+// Append only string in the frame arena, for text built and drawn in the same frame.
+struct frame_string
+{
+    char* buf = nullptr;
+    u32 length = 0;
+    u32 capacity = 0;
+
+    void reserve(u32 extra);
+    void append(const char* s);
+    void append(const char* s, u32 len);
+    void appendf(const char* fmt, ...);
+    void vappend(const char* fmt, va_list args);
+
+    const char* c_str() const { return buf ? buf : ""; }
+    u32 size() const { return length; }
+};
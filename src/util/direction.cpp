@@ -179,7 +179,7 @@ Direction getDirection(vec2i from, vec2i to)
     return getDirection(to - from);
 }
 
-std::vector<vec2i> findRay(vec2i from, vec2i to)
+frame_vector<vec2i> findRay(vec2i from, vec2i to)
 {
     float x0 = from.x + 0.5f;
     float y0 = from.y + 0.5f;
@@ -200,7 +200,7 @@ std::vector<vec2i> findRay(vec2i from, vec2i to)
     dx *= 2;
     dy *= 2;
 
-    std::vector<vec2i> result;
+    frame_vector<vec2i> result;
     for (; n > 0; --n)
     {
         if (error > 0)
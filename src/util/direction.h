@@ -2,6 +2,7 @@
 
 #include <vector>
 
+#include "arena.h"
 #include "vector_math.h"
 
 enum Direction : u8
@@ -39,4 +40,4 @@ Direction getDirection(float rad);
 Direction getDirection(vec2i dir);
 Direction getDirection(vec2i from, vec2i to);
 
-std::vector<vec2i> findRay(vec2i from, vec2i to);
+frame_vector<vec2i> findRay(vec2i from, vec2i to);
@@ -0,0 +1,74 @@
+#include "util/intern.h"
+
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+#include "util/linear_map.h"
+
+// Entries live in pages that are never moved or freed, so reading one needs no lock.
+constexpr u32 InternPageBits = 10;
+constexpr u32 InternPageSize = 1 << InternPageBits;
+constexpr u32 InternMaxPages = 1024;
+
+struct InternEntry
+{
+    const char* str;
+    u32 size;
+};
+
+struct InternTable
+{
+    std::mutex mutex;
+    linear_map<const char*, u32> ids;
+    InternEntry* pages[InternMaxPages] = {};
+    u32 count = 0;
+
+    InternTable()
+    {
+        pages[0] = new InternEntry[InternPageSize];
+        pages[0][0] = InternEntry{ "", 0 };
+        count = 1;
+    }
+};
+
+InternTable& internTable()
+{
+    static InternTable table;
+    return table;
+}
+
+istring::istring(const char* s)
+{
+    if (!s || !*s) return;
+
+    InternTable& t = internTable();
+    std::lock_guard<std::mutex> lock(t.mutex);
+    auto it = t.ids.find(s);
+    if (it.found)
+    {
+        id = it.value;
+        return;
+    }
+
+    debug_assertf(t.count < InternPageSize * InternMaxPages, "Intern table is full");
+    id = t.count++;
+    InternEntry*& page = t.pages[id >> InternPageBits];
+    if (!page) page = new InternEntry[InternPageSize];
+
+    u32 size = (u32)strlen(s);
+    char* copy = new char[size + 1];
+    memcpy(copy, s, size + 1);
+    page[id & (InternPageSize - 1)] = InternEntry{ copy, size };
+    t.ids.insert(copy, id);
+}
+
+const char* istring::c_str() const
+{
+    return internTable().pages[id >> InternPageBits][id & (InternPageSize - 1)].str;
+}
+
+u32 istring::size() const
+{
+    return internTable().pages[id >> InternPageBits][id & (InternPageSize - 1)].size;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "util/string.h"
+
+// Handle to a string in the global intern table. Equal strings share an id, so copying one is
+// copying a u32 and comparing two is an integer compare. Interned strings are never freed,
+// id 0 is the empty string.
+struct istring
+{
+    u32 id = 0;
+
+    istring() {}
+    istring(const char* s);
+    istring(const sstring& s) : istring(s.c_str()) {}
+
+    // Stays valid until exit, safe to call from any thread.
+    const char* c_str() const;
+    u32 size() const;
+    bool empty() const { return id == 0; }
+
+    bool operator==(istring o) const { return id == o.id; }
+    bool operator!=(istring o) const { return id != o.id; }
+};
@@ -355,6 +355,13 @@ struct linear_map
         return table_size;
     }
 
+    // Grows the table to at least size slots, it is never shrunk.
+    void reserve(u32 size) noexcept {
+        while (table_size < size) {
+            resize();
+        }
+    }
+
     bool empty() const noexcept {
         return item_count == 0;
     }
@@ -1,5 +1,7 @@
 #include "vterm.h"
 
+#include <cstring>
+
 TextBuffer::TextBuffer(int w, int h)
     : w(w), h(h)
 {
@@ -26,6 +28,21 @@ void TextBuffer::clear(int w0, int h0)
         buffer[i] = Char();
 }
 
+void TextBuffer::copyFrom(const TextBuffer& other)
+{
+    if (w != other.w || h != other.h)
+    {
+        delete[] buffer;
+        buffer = new Char[other.w * other.h];
+
+        w = other.w;
+        h = other.h;
+    }
+
+    memcpy(buffer, other.buffer, sizeof(Char) * w * h);
+    invert = other.invert;
+}
+
 void TextBuffer::write(vec2i p, const char* text, u32 color, int priority)
 {
     char n;
@@ -77,6 +77,8 @@ struct TextBuffer
     ~TextBuffer();
 
     void clear(int w, int h);
+    // Resizes to other's size and copies its cells.
+    void copyFrom(const TextBuffer& other);
     void write(vec2i p, const char* text, u32 color, int priority = 0);
     void fillText(vec2i from, vec2i to, char c, u32 color, int prio = 0);
     void fill(vec2i from, vec2i to, int id, u32 color, int prio = 0);
@@ -2,6 +2,8 @@
 
 #include <cstdio>
 
+#include "assets.h"
+#include "profiler.h"
 #include "vterm.h"
 
 Window g_window;
@@ -17,7 +19,7 @@ void window_open(const char* title, int w, int h)
     g_window.width = w;
     g_window.height = h;
 
-    Image img = LoadImage("assets/rl_text16.png");
+    Image img = loadAssetImage("rl_text16.png");
     g_window.font_texture = LoadTextureFromImage(img);
     UnloadImage(img);
 }
@@ -90,8 +92,9 @@ Color makeColor(u32 c)
     return col;
 }
 
-void render_buffer(TextBuffer* term, float zoom)
+void render_buffer(const TextBuffer* term, float zoom)
 {
+    PROFILE_ZONE("render_buffer");
     Camera2D camera = { 0 };
     camera.target = Vector2{ term->w / 2.0f, term->h / 2.0f };
     camera.offset = Vector2{ g_window.width / 2.0f, g_window.height / 2.0f };
@@ -105,7 +108,7 @@ void render_buffer(TextBuffer* term, float zoom)
     {
         for (int x = 0; x < term->w; ++x)
         {
-            TextBuffer::Char& ch = term->buffer[x + y * term->w];
+            const TextBuffer::Char& ch = term->buffer[x + y * term->w];
             if ((ch.bg & 0xFFFFFF) != 0)
             {
                 DrawRectangle(x, invy(y), 1, 1, makeColor(ch.bg));